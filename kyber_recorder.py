@@ -0,0 +1,258 @@
+import sys
+import mmap
+import struct
+import argparse
+from collections import OrderedDict
+
+# Analiza el registro de eventos de los cristales (kyber_rec.bin) copiado de
+# la SD de la placa:
+#   python kyber_recorder.py kyber_rec.bin [--dump]
+# Mismo formato que props/kyber_recorder.h: un anillo de registros de 16 bytes.
+#   0     tipo, 1 código (bit 7 = segundo cristal), 2-3 duración
+#   (bit 15 a 0 en us, a 1 en ms), 4-7 millis(), 8-11 UID (4 bytes),
+#   12-14 secuencia, 15 CRC-8 de los bytes 0-14.
+
+RECORD = struct.Struct("<BBHI4s3sB")
+SEQUENCE_MASK = 0xFFFFFF
+SECOND = 0x80
+
+EVENTS = {
+    1: "BOOT", 2: "DETECT", 3: "READ", 4: "APPLY", 5: "SWAP", 6: "SAVE",
+    7: "WINDOW_OPEN", 8: "TIMEOUT", 9: "LED", 10: "REMOVED", 11: "DROPPED",
+}
+BOOT, DETECT, READ, APPLY, SWAP, SAVE, WINDOW_OPEN, TIMEOUT, LED, REMOVED, DROPPED = range(1, 12)
+
+READ_CODES = ["ok", "cached", "retry", "failed", "invalid", "aborted"]
+APPLY_CODES = ["color", "rebuild", "live"]
+
+# Eventos que indican que la ventana NFC ha servido para algo.
+ACTIVITY = (DETECT, READ, APPLY, REMOVED)
+
+
+def crc8(data):
+    crc = 0
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def duration_us(raw):
+    return (raw & 0x7FFF) * 1000 if raw & 0x8000 else raw
+
+
+class Event:
+    __slots__ = ("type", "code", "us", "millis", "uid", "seq", "boot")
+
+    def __init__(self, fields, boot):
+        self.type, self.code, raw, self.millis, uid, seq, _ = fields
+        self.us = duration_us(raw)
+        self.uid = uid.hex().upper() if any(uid) else ""
+        self.seq = int.from_bytes(seq, "little")
+        self.boot = boot
+
+    @property
+    def second(self):
+        return self.type in (DETECT, READ, REMOVED) and bool(self.code & SECOND)
+
+    def describe(self):
+        name = EVENTS.get(self.type, f"?{self.type}")
+        code = self.code & ~SECOND if self.type in (DETECT, READ, REMOVED) else self.code
+        if self.type == READ:
+            detail = READ_CODES[code] if code < len(READ_CODES) else str(code)
+        elif self.type == APPLY:
+            detail = APPLY_CODES[code] if code < len(APPLY_CODES) else str(code)
+        elif self.type == SAVE:
+            detail = "ok" if code == 0 else "error"
+        elif self.type == TIMEOUT:
+            detail = "sleep" if code == 0 else "sleep failed"
+        elif self.type == LED:
+            detail = "on" if code else "off"
+        elif self.type == DETECT:
+            detail = f"tg {code}"
+        elif self.type == DROPPED:
+            detail = f"{code} perdidos"
+        else:
+            detail = ""
+        if self.second:
+            detail += " (2º)"
+        return name, detail.strip()
+
+
+# Lee el anillo con mmap y devuelve los eventos en orden. La escritura sigue
+# tras el primer registro roto o que no continúa la secuencia del anterior.
+def load(filename):
+    with open(filename, "rb") as f:
+        data = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+    try:
+        records = []
+        for offset in range(0, len(data) - RECORD.size + 1, RECORD.size):
+            raw = data[offset:offset + RECORD.size]
+            valid = raw[0] != 0 and crc8(raw[:-1]) == raw[-1]
+            records.append(RECORD.unpack(raw) if valid else None)
+    finally:
+        data.close()
+
+    def sequence(fields):
+        return int.from_bytes(fields[5], "little")
+
+    head = len(records)
+    for i, fields in enumerate(records):
+        if fields is None or (i > 0 and sequence(fields) != (sequence(records[i - 1]) + 1) & SEQUENCE_MASK):
+            head = i
+            break
+
+    # El registro más nuevo es el de justo antes de head; el resto va en orden
+    # de secuencia a partir de él, dando la vuelta al anillo.
+    valid = [r for r in records if r is not None]
+    before = [r for r in records[:head] if r is not None]
+    ordered = []
+    if valid:
+        newest = sequence(before[-1] if before else valid[-1])
+        ordered = sorted(valid, key=lambda r: (sequence(r) - newest - 1) & SEQUENCE_MASK)
+
+    events = []
+    boot = 0
+    for fields in ordered:
+        if fields[0] == BOOT:
+            boot += 1
+        events.append(Event(fields, boot))
+    return events, len(records), len(records) - len(ordered)
+
+
+def percentile(values, p):
+    if not values:
+        return 0
+    values = sorted(values)
+    k = min(len(values) - 1, max(0, int(round(p / 100.0 * (len(values) - 1)))))
+    return values[k]
+
+
+def print_distribution(title, values_ms):
+    print(f"\n{title}: {len(values_ms)}")
+    if not values_ms:
+        return
+    print(f"  min {min(values_ms):.1f}  p50 {percentile(values_ms, 50):.1f}  p90 {percentile(values_ms, 90):.1f}"
+          f"  p99 {percentile(values_ms, 99):.1f}  max {max(values_ms):.1f} ms")
+    # Histograma logarítmico: <1 ms, <2 ms, <4 ms...
+    buckets = OrderedDict()
+    limit = 1
+    while True:
+        buckets[limit] = 0
+        if limit > max(values_ms):
+            break
+        limit *= 2
+    for v in values_ms:
+        for limit in buckets:
+            if v < limit:
+                buckets[limit] += 1
+                break
+    peak = max(buckets.values())
+    for limit, count in buckets.items():
+        bar = "#" * (count * 40 // peak if peak else 0)
+        print(f"  <{limit:6d} ms {count:6d} {bar}")
+
+
+def report_swaps(events):
+    print_distribution("Cambios de cristal (detección hasta primer frame)",
+                       [e.us / 1000.0 for e in events if e.type == SWAP])
+    print_distribution("Lecturas completas (detección hasta datos)",
+                       [e.us / 1000.0 for e in events if e.type == READ and e.code == 0])
+    print_distribution("Aplicaciones (trabajo del prop)",
+                       [e.us / 1000.0 for e in events if e.type == APPLY])
+
+
+def report_reads(events):
+    per_uid = OrderedDict()
+    for e in events:
+        if e.type != READ:
+            continue
+        key = (e.uid or "?", e.second)
+        counts = per_uid.setdefault(key, [0] * len(READ_CODES))
+        code = e.code & ~SECOND
+        if code < len(READ_CODES):
+            counts[code] += 1
+
+    print("\nLecturas por cristal (UID, 4 primeros bytes):")
+    if not per_uid:
+        print("  ninguna")
+        return
+    print("  UID           " + " ".join(f"{c:>8}" for c in READ_CODES) + "  fallos  reintentos")
+    for (uid, second), c in sorted(per_uid.items(), key=lambda item: -sum(item[1])):
+        ok, cached, retry, failed, invalid, aborted = c
+        # Cada lectura termina en ok, failed, invalid o aborted; retry es un READ
+        # fallido que se retoma y cached no lee páginas.
+        attempts = ok + failed + invalid + aborted
+        failure = 100.0 * (failed + invalid + aborted) / attempts if attempts else 0.0
+        retries = retry / attempts if attempts else 0.0
+        name = uid + (" (2º)" if second else "")
+        print(f"  {name:13} " + " ".join(f"{v:8d}" for v in c) + f"  {failure:5.1f}%  {retries:5.2f}/lectura")
+
+
+def report_windows(events):
+    windows = []
+    current = None
+    for e in events:
+        if e.type == BOOT:
+            current = None
+        elif e.type == WINDOW_OPEN:
+            current = {"boot": e.boot, "open": e.millis, "last": None, "detects": 0, "reads": 0}
+        elif current is None:
+            continue
+        elif e.type in ACTIVITY:
+            current["last"] = e.millis
+            current["detects"] += e.type == DETECT
+            current["reads"] += e.type == READ
+        elif e.type == TIMEOUT:
+            current["length"] = e.millis - current["open"]
+            windows.append(current)
+            current = None
+
+    print(f"\nVentanas NFC cerradas por timeout: {len(windows)}")
+    if not windows:
+        return
+    total = sum(w["length"] for w in windows)
+    used = sum(w["last"] - w["open"] for w in windows if w["last"] is not None)
+    idle = sum(1 for w in windows if w["last"] is None)
+    print(f"  duración media {total / len(windows) / 1000.0:.1f} s, RF encendido {total / 1000.0:.1f} s en total")
+    print(f"  sin ningún cristal: {idle}/{len(windows)}")
+    print(f"  utilización (hasta el último evento de cristal): {100.0 * used / total if total else 0.0:.1f}%")
+    last = [(w["last"] - w["open"]) / 1000.0 for w in windows if w["last"] is not None]
+    if last:
+        print(f"  último evento tras abrir: p50 {percentile(last, 50):.1f} s  p90 {percentile(last, 90):.1f} s"
+              f"  max {max(last):.1f} s")
+
+
+def dump(events):
+    print(f"{'seq':>8} {'arr':>3} {'millis':>10}  {'evento':12} {'UID':9} {'duración':>10}  detalle")
+    for e in events:
+        name, detail = e.describe()
+        duration = f"{e.us / 1000.0:.1f} ms" if e.us else ""
+        print(f"{e.seq:8d} {e.boot:3d} {e.millis:10d}  {name:12} {e.uid:9} {duration:>10}  {detail}")
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Analiza el registro de eventos de Kyber NFC (kyber_rec.bin)")
+    parser.add_argument("file", help="kyber_rec.bin copiado de la SD")
+    parser.add_argument("--dump", action="store_true", help="lista todos los eventos en orden")
+    args = parser.parse_args()
+
+    try:
+        events, records, broken = load(args.file)
+    except (OSError, ValueError) as e:
+        print(f"Error: {e}")
+        sys.exit(1)
+
+    print(f"{len(events)} eventos de {records} registros ({broken} vacíos o rotos), "
+          f"{sum(1 for e in events if e.type == BOOT)} arranques")
+    dropped = sum(e.code for e in events if e.type == DROPPED)
+    if dropped:
+        print(f"Eventos perdidos con el buffer lleno: {dropped}")
+
+    if args.dump:
+        dump(events)
+    else:
+        report_swaps(events)
+        report_reads(events)
+        report_windows(events)
@@ -1,464 +1,855 @@
-import sys
-import time
-from tkinter import *
-from tkinter import ttk, colorchooser, messagebox
-from PIL import Image, ImageTk
-from smartcard.System import readers
-from smartcard.util import toBytes, toHexString
-import ttkbootstrap as ttk
-from ttkbootstrap.constants import *
-
-#################### NFC FUNCTIONS ####################
-
-def connect_reader():
-    r = readers()
-    if not r:
-        raise Exception("No hay lectores NFC conectados.")
-    reader = r[0]
-    conn = reader.createConnection()
-    conn.connect()
-    
-    # Desactivar el buzzer del ACR122U.
-    try:
-        buzz_off = [0xFF, 0x00, 0x52, 0x00, 0x00]
-        conn.transmit(buzz_off)
-    except:
-        pass
-    
-    return conn
-
-# Escribir página.
-def ntag_write_page(conn, page, data4, retries=3):
-    if len(data4) != 4:
-        raise Exception("El bloque debe tener exactamente 4 bytes.")
-
-    # APDU: FF D6 00 [page] 04 [data]
-    cmd = [0xFF, 0xD6, 0x00, page, 0x04] + data4
-
-    print(f"[WRITE] Página {page}: {data4} -> HEX: {toHexString(data4)}")
-    print(f"[WRITE] Comando completo: {toHexString(cmd)}")
-    
-    last_error = None
-    for attempt in range(retries):
-        try:
-            # Pausa progresivamente mayor en cada reintento.
-            if attempt > 0:
-                wait_time = 0.2 * (attempt + 1)  # 0.2s, 0.4s, 0.6s
-                print(f"[WRITE] Reintento {attempt + 1}/{retries} (esperando {wait_time}s)")
-                time.sleep(wait_time)
-            
-            resp, sw1, sw2 = conn.transmit(cmd)
-            print(f"[WRITE] Respuesta SW: {sw1:02X} {sw2:02X}, Resp: {resp}")
-            
-            if (sw1, sw2) == (0x90, 0x00):
-                # Éxito. Pausa más larga antes de siguiente operación.
-                time.sleep(0.2)
-                return
-            elif (sw1, sw2) == (0x63, 0x00):
-                # Error 63 00
-                last_error = f"Error temporal al escribir página {page}: SW={sw1:02X}{sw2:02X}"
-                print(f"[WRITE] {last_error}")
-                continue
-            else:
-                raise Exception(f"Error al escribir página {page}: SW={sw1:02X}{sw2:02X}")
-                
-        except Exception as e:
-            if "Error al escribir" in str(e):
-                raise
-            last_error = str(e)
-            print(f"[WRITE] Excepción en intento {attempt + 1}: {e}")
-    
-    # Si todos los intentos fallaron...
-    raise Exception(f"Falló después de {retries} intentos: {last_error}")
-
-# Leer página.
-def ntag_read_page(conn, page):
-    # APDU: FF B0 00 [page] [length]
-    cmd = [0xFF, 0xB0, 0x00, page, 0x04]
-    
-    resp, sw1, sw2 = conn.transmit(cmd)
-    print(f"[READ] Página {page} - SW: {sw1:02X} {sw2:02X}")
-    print(f"[READ] Respuesta completa: {resp}")
-    
-    if (sw1, sw2) != (0x90, 0x00):
-        raise Exception(f"Error al leer página {page}: SW={sw1:02X}{sw2:02X}")
-
-    data = resp[:4]
-    print(f"[READ] Datos: {data} -> HEX: {toHexString(data)}")
-    return data
-
- ################ GET UID ################
-
-def ntag_get_uid(conn):
-    cmd = [0xFF, 0xCA, 0x00, 0x00, 0x00]
-    resp, sw1, sw2 = conn.transmit(cmd)
-
-    if (sw1, sw2) != (0x90, 0x00):
-        raise Exception(f"Error leyendo UID: SW={sw1:02X}{sw2:02X}")
-
-    return resp
-
-#################### GUI ####################
-
-class App:
-    def __init__(self, root):
-        self.root = root
-        self.root.title("Arkaivos Kyber Lab")
-
-        self.color_rgb = (255, 255, 255)
-        self.text_var = StringVar()
-        self.owner_var = StringVar()
-        self.color_hex_var = StringVar(value="#000000")
-        self.firma_valida = IntVar(value=0)
-
-        # Cargar imagen base.
-        try:
-            self.base_image = Image.open("kyber.png").convert("RGBA")
-            # Redimensionar manteniendo aspect ratio 2:3.
-            target_height = 120
-            target_width = int(target_height * 2 / 3)
-            self.base_image = self.base_image.resize((target_width, target_height), Image.LANCZOS)
-        except Exception as e:
-            messagebox.showerror("Error", f"No se pudo cargar la imagen: {e}")
-            self.base_image = None
-
-        self.build_ui()
-
-    def build_ui(self):
-        frm = ttk.Frame(self.root, padding=10)
-        frm.grid(row=0, column=0)
-
-        # Configurar pesos de columnas para distribuir mejor el espacio.
-        frm.columnconfigure(1, weight=0)
-        frm.columnconfigure(2, weight=1)
-
-        # Color selector.
-        ttk.Label(frm, text="Color RGB:").grid(row=0, column=0, sticky="w", pady=(0, 8))
-        ttk.Entry(frm, textvariable=self.color_hex_var, width=10).grid(row=0, column=1, sticky="w", padx=5, pady=(0, 8))
-        ttk.Button(frm, text="Select color", command=self.choose_color).grid(row=0, column=2, sticky="w", pady=(0, 8))
-
-        self.style_label_color = "UIDLabel.TLabel"
-        self.style = ttk.Style()
-        self.style.configure(self.style_label_color, foreground="#FFFFFF")  # color inicial negro
-
-        # Color preview
-        if self.base_image:
-            self.color_preview = ttk.Label(frm)
-            self.color_preview.grid(row=0, column=3, padx=(30, 20), pady=(10, 0),rowspan= 3, sticky="n")
-            self.update_color_preview()
-        else:
-            self.color_preview = Canvas(frm, width=40, height=20, bg="#000000")
-            self.color_preview.grid(row=0, column=3, padx=10, sticky="e")
-
-        # Text
-        ttk.Label(frm, text="Preset: ").grid(row=1, column=0, sticky="w", pady=(0, 20))
-        vcmd = (frm.register(self.validate_text), "%P")
-
-        self.entry_text = ttk.Entry(
-            frm,
-            textvariable=self.text_var,
-            width=25,
-            validate="key",
-            validatecommand=vcmd
-        )
-        self.entry_text.grid(row=1, column=1, columnspan=2, sticky="ew", padx=5, pady=(0, 20))
-
-        # Propietario.
-        ttk.Label(frm, text="Attuned to:").grid(row=2, column=0, sticky="w", padx=(0, 5), pady=(0, 20))
-        vcmd_owner = (frm.register(self.validate_owner), "%P")
-
-        self.entry_owner = ttk.Entry(
-            frm,
-            textvariable=self.owner_var,
-            width=25,
-            validate="key",
-            validatecommand=vcmd_owner
-        )
-        self.entry_owner.grid(row=2, column=1, columnspan=2, sticky="ew", padx=(5, 5), pady=(0, 20))
-
-        # Botones.
-        ttk.Button(frm, text="Write Crystal", command=self.write_tag).grid(row=3, column=0, columnspan=1, pady=(0, 0), sticky="ew", padx=(0, 2))
-        ttk.Button(frm, text="Read Crystal", command=self.read_tag).grid(row=3, column=1, columnspan=2, pady=(0, 0), sticky="ew", padx=(2, 0))
-        # ttk.Button(frm, text="Ver Config/Bloqueo", command=self.check_lock).grid(row=2, column=2, pady=10)
-
-        self.uid_var = ttk.StringVar(value="Crystal UID")
-        self.uid_label = ttk.Label(
-            frm,
-            textvariable=self.uid_var,
-            style=self.style_label_color,
-            bootstyle="info"
-        )
-        self.uid_label.grid(row=3, column=3, columnspan=1, pady=(0, 0), padx=(5, 0), sticky="s")
-
-
-    def validate_text(self, new_value):
-        return len(new_value) <= 8
-
-    def validate_owner(self, new_value):
-        return len(new_value) <= 12
-
-    def choose_color(self):
-        color = colorchooser.askcolor()[0]
-        if color:
-            r, g, b = int(color[0]), int(color[1]), int(color[2])
-            self.color_rgb = (r, g, b)
-            hexcode = "#%02x%02x%02x" % (r, g, b)
-            self.color_hex_var.set(hexcode)
-            self.update_color_preview()
-
-    def update_color_preview(self):
-        r, g, b = self.color_rgb
-        hex_color = "#%02x%02x%02x" % (r, g, b)
-        self.style.configure(self.style_label_color, foreground=hex_color)
-
-        if not self.base_image:
-            # Fallback...
-            return
-        
-        # Trabajar con RGBA
-        img_rgba = self.base_image.copy()
-        pixels = img_rgba.load()
-        width, height = img_rgba.size
-        
-        import colorsys
-        h_target, s_target, v_target = colorsys.rgb_to_hsv(r/255.0, g/255.0, b/255.0)
-        
-        for y in range(height):
-            for x in range(width):
-                pixel = pixels[x, y]
-                gray = pixel[0]  # Canal R (en escala de grises da igual cual coger).
-                alpha = pixel[3]  # Canal alfa.
-                
-                v_original = gray / 255.0
-                new_r, new_g, new_b = colorsys.hsv_to_rgb(h_target, s_target, v_original)
-                
-                pixels[x, y] = (
-                    int(new_r * 255),
-                    int(new_g * 255),
-                    int(new_b * 255),
-                    alpha  # Mantener transparencia original.
-                )
-        
-        self.photo = ImageTk.PhotoImage(img_rgba)
-        self.color_preview.config(image=self.photo)
-        self.color_preview.image = self.photo
-
-    ################ WRITE ################
-
-    def write_tag(self):
-        print("\n========== INICIANDO ESCRITURA ==========")
-        
-        # Get color
-        text = self.text_var.get()[:8]
-        owner = self.owner_var.get()[:12]
-        r, g, b = self.color_rgb
-
-        print(f"Color a escribir: RGB({r}, {g}, {b})")
-        print(f"Texto a escribir: '{text}' (longitud: {len(text)})")
-        print(f"Propietario a escribir: '{owner}' (longitud: {len(owner)})")
-
-        # Generamos las páginas.
-        # Página 4: R G B len(text)
-        p4 = [r, g, b, len(text)]
-
-        # El texto del preset entre la 5 y la 6.
-        text_bytes = [ord(c) for c in text]
-        while len(text_bytes) < 8:
-            text_bytes.append(0)
-
-        p5 = text_bytes[0:4]
-        p6 = text_bytes[4:8]
-
-        # El nombre del propietario entre la 7, 8 y 9 (12 caracteres).
-        owner_bytes = [ord(c) for c in owner]
-        while len(owner_bytes) < 12:
-            owner_bytes.append(0)
-
-        p7 = owner_bytes[0:4]
-        p8 = owner_bytes[4:8]
-        p9 = owner_bytes[8:12]
-
-        # FIRMA DE LOS DATOS########################
-        firma = "ArkaivosKybr"
-        firma_bytes = [ord(c) for c in firma]
-        # Combinar y firmar.
-        data = p4 + p5 + p6
-        signed_data = [b ^ f for b, f in zip(data, firma_bytes)]
-        # Repartir en páginas.
-        p4 = signed_data[0:4]
-        p5 = signed_data[4:8]
-        p6 = signed_data[8:12]
-        ############################################
-
-        max_attempts = 2
-        for global_attempt in range(max_attempts):
-            try:
-                if global_attempt > 0:
-                    print(f"\n[GLOBAL] Reintento completo {global_attempt + 1}/{max_attempts}")
-                    time.sleep(0.3)
-                
-                conn = connect_reader()
-                
-                ntag_write_page(conn, 4, p4)
-                ntag_write_page(conn, 5, p5)
-                ntag_write_page(conn, 6, p6)
-                ntag_write_page(conn, 7, p7)
-                ntag_write_page(conn, 8, p8)
-                ntag_write_page(conn, 9, p9)
-                
-                print("========== ESCRITURA COMPLETADA ==========\n")
-                
-                # Verificación inmediata
-                print("========== VERIFICANDO ESCRITURA ==========")
-                time.sleep(0.2)
-                p4_verify = ntag_read_page(conn, 4)
-                p5_verify = ntag_read_page(conn, 5)
-                p6_verify = ntag_read_page(conn, 6)
-                p7_verify = ntag_read_page(conn, 7)
-                p8_verify = ntag_read_page(conn, 8)
-                p9_verify = ntag_read_page(conn, 9)
-                print(f"Verificación P4: {list(p4_verify)}")
-                print(f"Verificación P5: {list(p5_verify)}")
-                print(f"Verificación P6: {list(p6_verify)}")
-                print(f"Verificación P7: {list(p7_verify)}")
-                print(f"Verificación P8: {list(p8_verify)}")
-                print(f"Verificación P9: {list(p9_verify)}")
-                print("========== VERIFICACIÓN COMPLETADA ==========\n")
-                
-                messagebox.showinfo("OK", "Cristal Kyber generado correctamente.")
-                return
-                
-            except Exception as e:
-                print(f"[GLOBAL] Error en intento {global_attempt + 1}: {e}")
-                if global_attempt == max_attempts - 1:
-                    messagebox.showerror("Error", str(e))
-                    return
-
-    ################ READ ################
-
-    def read_tag(self):
-        print("\n========== INICIANDO LECTURA ==========")
-        try:
-            conn = connect_reader()
-            uid = ntag_get_uid(conn)
-            print("UID del tag:", toHexString(uid))
-            uid_hex = toHexString(uid)
-            self.uid_var.set(f"{uid_hex}")
-        except Exception as e:
-            messagebox.showerror("Error", str(e))
-            return
-
-        try:
-            p4 = ntag_read_page(conn, 4)
-            p5 = ntag_read_page(conn, 5)
-            p6 = ntag_read_page(conn, 6)
-            p7 = ntag_read_page(conn, 7)
-            p8 = ntag_read_page(conn, 8)
-            p9 = ntag_read_page(conn, 9)
-        except Exception as e:
-            messagebox.showerror("Error", str(e))
-            return
-
-        # FIRMA DE LOS DATOS########################
-        firma = "ArkaivosKybr" # 12 bytes
-        firma_bytes = [ord(c) for c in firma] # -> lista de 12 enteros
-        signed_data = p4 + p5 + p6 # 12 bytes
-        data = [b ^ f for b, f in zip(signed_data, firma_bytes)]
-        p4 = data[0:4]
-        p5 = data[4:8]
-        p6 = data[8:12]
-        ############################################
-
-        r, g, b, length = p4
-        text_bytes = p5 + p6
-        text = "".join(chr(c) for c in text_bytes[:length])
-
-        # Extraer propietario (12 caracteres) - SIN DESCIFRAR.
-        owner_bytes = p7 + p8 + p9
-        # Buscar el primer byte 0 para determinar longitud real.
-        owner_length = 12
-        for i, byte in enumerate(owner_bytes):
-            if byte == 0:
-                owner_length = i
-                break
-        owner = "".join(chr(c) for c in owner_bytes[:owner_length])
-
-        self.firma_valida.set(0)
-
-        print(f"Color leído: RGB({r}, {g}, {b})")
-        print(f"Texto leído: '{text}'")
-        print(f"Propietario leído: '{owner}'")
-        print("========== LECTURA COMPLETADA ==========\n")
-
-        self.color_rgb = (r, g, b)
-        self.color_hex_var.set("#%02x%02x%02x" % (r, g, b))
-        self.update_color_preview()
-
-        self.text_var.set(text)
-        self.owner_var.set(owner)
-
-    ################ CHECK LOCK ################
-    """
-    def check_lock(self):
-        print("\n========== VERIFICANDO CONFIGURACIÓN ==========")
-        try:
-            conn = connect_reader()
-        except Exception as e:
-            messagebox.showerror("Error", str(e))
-            return
-
-        try:
-            # Página 2: Lock bytes
-            p2 = ntag_read_page(conn, 2)
-            print(f"Página 2 (Lock bytes): {list(p2)} -> {toHexString(p2)}")
-            
-            # Página 3: CC (Capability Container)
-            p3 = ntag_read_page(conn, 3)
-            print(f"Página 3 (CC): {list(p3)} -> {toHexString(p3)}")
-            
-            # Páginas 40-41: Dynamic lock bytes (NTAG213)
-            p40 = ntag_read_page(conn, 40)
-            print(f"Página 40 (Dynamic Lock): {list(p40)} -> {toHexString(p40)}")
-            
-            p41 = ntag_read_page(conn, 41)
-            print(f"Página 41 (CFG0): {list(p41)} -> {toHexString(p41)}")
-            
-            p42 = ntag_read_page(conn, 42)
-            print(f"Página 42 (CFG1): {list(p42)} -> {toHexString(p42)}")
-            
-            # Análisis
-            info = "CONFIGURACIÓN DEL TAG:\n\n"
-            info += f"Lock bytes (P2): {toHexString(p2)}\n"
-            info += f"Capability Container (P3): {toHexString(p3)}\n"
-            info += f"Dynamic Lock (P40): {toHexString(p40)}\n"
-            info += f"CFG0 (P41): {toHexString(p41)}\n"
-            info += f"CFG1 (P42): {toHexString(p42)}\n\n"
-            
-            # Interpretación de lock bytes
-            if p2[2] != 0x00 or p2[3] != 0x00:
-                info += "- PÁGINAS BLOQUEADAS detectadas en P2\n"
-            if p40[0] != 0x00 or p40[1] != 0x00 or p40[2] != 0x00:
-                info += "- PÁGINAS BLOQUEADAS detectadas en P40\n"
-            
-            # AUTH0 (primer byte de CFG1) - primera página que requiere autenticación
-            auth0 = p42[3]
-            info += f"\nAUTH0 = {auth0} (0x{auth0:02X})\n"
-            if auth0 <= 8:
-                info += f"- Las páginas {auth0}-42 requieren autenticación para escritura\n"
-            
-            print(info)
-            messagebox.showinfo("Configuración del Tag", info)
-            
-        except Exception as e:
-            messagebox.showerror("Error", str(e))
-            print(f"Error leyendo configuración: {e}")
-        
-        print("========== VERIFICACIÓN COMPLETADA ==========\n")
-    """
-
-#################### MAIN ####################
-
-if __name__ == "__main__":
-    root = ttk.Window(themename="darkly") 
-    app = App(root)
+import sys
+import csv
+import json
+import argparse
+import time
+from tkinter import *
+from tkinter import ttk, colorchooser, messagebox
+from PIL import Image, ImageTk
+from smartcard.System import readers
+from smartcard.util import toBytes, toHexString
+from smartcard.scard import *
+import ttkbootstrap as ttk
+from ttkbootstrap.constants import *
+
+#################### NFC FUNCTIONS ####################
+
+def connect_reader():
+    r = readers()
+    if not r:
+        raise Exception("No hay lectores NFC conectados.")
+    reader = r[0]
+    conn = reader.createConnection()
+    conn.connect()
+    
+    # Desactivar el buzzer del ACR122U.
+    try:
+        buzz_off = [0xFF, 0x00, 0x52, 0x00, 0x00]
+        conn.transmit(buzz_off)
+    except:
+        pass
+    
+    return conn
+
+# Escribir página. settle es la pausa tras una escritura correcta.
+def ntag_write_page(conn, page, data4, retries=3, settle=0.2, verbose=True):
+    if len(data4) != 4:
+        raise Exception("El bloque debe tener exactamente 4 bytes.")
+
+    # APDU: FF D6 00 [page] 04 [data]
+    cmd = [0xFF, 0xD6, 0x00, page, 0x04] + data4
+
+    if verbose:
+        print(f"[WRITE] Página {page}: {data4} -> HEX: {toHexString(data4)}")
+        print(f"[WRITE] Comando completo: {toHexString(cmd)}")
+    
+    last_error = None
+    for attempt in range(retries):
+        try:
+            # Pausa progresivamente mayor en cada reintento.
+            if attempt > 0:
+                wait_time = 0.2 * (attempt + 1)  # 0.2s, 0.4s, 0.6s
+                print(f"[WRITE] Reintento {attempt + 1}/{retries} (esperando {wait_time}s)")
+                time.sleep(wait_time)
+            
+            resp, sw1, sw2 = conn.transmit(cmd)
+            if verbose:
+                print(f"[WRITE] Respuesta SW: {sw1:02X} {sw2:02X}, Resp: {resp}")
+            
+            if (sw1, sw2) == (0x90, 0x00):
+                # Éxito. Pausa más larga antes de siguiente operación.
+                if settle:
+                    time.sleep(settle)
+                return
+            elif (sw1, sw2) == (0x63, 0x00):
+                # Error 63 00
+                last_error = f"Error temporal al escribir página {page}: SW={sw1:02X}{sw2:02X}"
+                print(f"[WRITE] {last_error}")
+                continue
+            else:
+                raise Exception(f"Error al escribir página {page}: SW={sw1:02X}{sw2:02X}")
+                
+        except Exception as e:
+            if "Error al escribir" in str(e):
+                raise
+            last_error = str(e)
+            print(f"[WRITE] Excepción en intento {attempt + 1}: {e}")
+    
+    # Si todos los intentos fallaron...
+    raise Exception(f"Falló después de {retries} intentos: {last_error}")
+
+# Leer página.
+def ntag_read_page(conn, page):
+    # APDU: FF B0 00 [page] [length]
+    cmd = [0xFF, 0xB0, 0x00, page, 0x04]
+    
+    resp, sw1, sw2 = conn.transmit(cmd)
+    print(f"[READ] Página {page} - SW: {sw1:02X} {sw2:02X}")
+    print(f"[READ] Respuesta completa: {resp}")
+    
+    if (sw1, sw2) != (0x90, 0x00):
+        raise Exception(f"Error al leer página {page}: SW={sw1:02X}{sw2:02X}")
+
+    data = resp[:4]
+    print(f"[READ] Datos: {data} -> HEX: {toHexString(data)}")
+    return data
+
+ ################ GET UID ################
+
+def ntag_get_uid(conn):
+    cmd = [0xFF, 0xCA, 0x00, 0x00, 0x00]
+    resp, sw1, sw2 = conn.transmit(cmd)
+
+    if (sw1, sw2) != (0x90, 0x00):
+        raise Exception(f"Error leyendo UID: SW={sw1:02X}{sw2:02X}")
+
+    return resp
+
+#################### FORMATO DEL CRISTAL ####################
+# Mismo formato que props/kyber_tag.h. Los datos empiezan en la página 4.
+#
+# v1: páginas 4-6 R G B longitud nombre(8) con XOR "ArkaivosKybr",
+#     páginas 7-9 propietario (12 bytes, sin firmar).
+# v2: 0xC2 L CRC-16(LE) R G B campos..., con campos TLV de cabecera
+#     tipo(3 bits) | longitud(5 bits). El CRC cubre la marca, L y el cuerpo.
+
+FIRST_DATA_PAGE = 4
+V1_BYTES = 24
+V2_MARKER = 0xC2
+V2_HEADER = 4
+MAX_TAG_BYTES = 80
+MAX_NAME = 24
+MAX_OWNER = 24
+MAX_BLADE_COLORS = 4
+
+FIELD_END = 0
+FIELD_NAME = 1
+FIELD_OWNER = 2
+FIELD_FLAGS = 3
+FIELD_BLADE_COLOR = 4
+
+# Efecto del LED del cristal (flags, bits 0-1). 0 = el de la configuración.
+CRYSTAL_EFFECTS = ["Default", "Pulse", "Breathe", "Sparkle"]
+
+FIRMA = [ord(c) for c in "ArkaivosKybr"]
+
+def crc16(data, crc=0xFFFF):
+    # CRC-16/CCITT-FALSE.
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+def text_bytes(text, max_length):
+    data = text.encode("ascii")
+    if len(data) > max_length:
+        raise Exception(f"'{text}' supera {max_length} caracteres.")
+    if any(c < 32 or c > 126 for c in data):
+        raise Exception(f"'{text}' tiene caracteres no imprimibles.")
+    return list(data)
+
+def encode_tag(color, name, owner="", flags=0, blade_colors=()):
+    """Codifica un cristal v2. Devuelve los bytes rellenos hasta páginas completas."""
+    body = list(color)
+
+    def field(field_type, value):
+        body.append((field_type << 5) | len(value))
+        body.extend(value)
+
+    if name:
+        field(FIELD_NAME, text_bytes(name, MAX_NAME))
+    if owner:
+        field(FIELD_OWNER, text_bytes(owner, MAX_OWNER))
+    if flags:
+        field(FIELD_FLAGS, [flags])
+    if len(blade_colors) > MAX_BLADE_COLORS:
+        raise Exception(f"Como mucho {MAX_BLADE_COLORS} colores por filo.")
+    for blade, (r, g, b) in blade_colors:
+        field(FIELD_BLADE_COLOR, [blade, r, g, b])
+
+    if V2_HEADER + len(body) > MAX_TAG_BYTES:
+        raise Exception(f"Los datos del cristal superan {MAX_TAG_BYTES} bytes.")
+
+    header = [V2_MARKER, len(body)]
+    crc = crc16(header + body)
+    data = header + [crc & 0xFF, crc >> 8] + body
+    while len(data) % 4:
+        data.append(FIELD_END)
+    return data
+
+def valid_v2(data):
+    if len(data) < V2_HEADER or data[0] != V2_MARKER:
+        return False
+    length = data[1]
+    if length < 3 or length > MAX_TAG_BYTES - V2_HEADER or len(data) < V2_HEADER + length:
+        return False
+    crc = crc16(data[:2] + data[V2_HEADER:V2_HEADER + length])
+    return crc == data[2] | (data[3] << 8)
+
+def needs_more(data):
+    """Indica si faltan páginas por leer para decodificar el cristal."""
+    if data[0] == V2_MARKER and 3 <= data[1] <= MAX_TAG_BYTES - V2_HEADER:
+        if len(data) < V2_HEADER + data[1]:
+            return True
+        # Con el CRC bien pero los campos mal puede ser un v1: decode_tag()
+        # lo intentará con sus 24 bytes.
+        if decode_v2(data) is not None:
+            return False
+    return len(data) < V1_BYTES
+
+def printable(data):
+    return all(32 <= c <= 126 for c in data)
+
+def decode_tag(data):
+    """Decodifica un cristal v1 o v2. Devuelve un diccionario o None si no es válido.
+
+    Igual que KyberTagCodec::decode() en props/kyber_tag.h."""
+    if len(data) >= V2_HEADER and data[0] == V2_MARKER:
+        tag = decode_v2(data)
+        if tag is not None:
+            return tag
+        # Puede ser un v1 con R = 0x83: solo si su nombre es válido.
+        return decode_v1(data, strict=True)
+    return decode_v1(data, strict=False)
+
+def decode_v1(data, strict):
+    if len(data) < V1_BYTES:
+        return None
+    decoded = [b ^ f for b, f in zip(data[:12], FIRMA)]
+    r, g, b, length = decoded[:4]
+    if length > 8:
+        if strict:
+            return None
+        length = 8
+    name = decoded[4:4 + length]
+    if not printable(name):
+        if strict:
+            return None
+        name = []
+
+    # Propietario sin firmar, termina en el primer byte 0.
+    owner = []
+    for c in data[12:24]:
+        if c == 0:
+            break
+        owner.append(c)
+    if not printable(owner):
+        owner = []
+
+    return {
+        "version": 1,
+        "color": (r, g, b),
+        "name": bytes(name).decode("ascii"),
+        "owner": bytes(owner).decode("ascii"),
+        "flags": 0,
+        "blade_colors": [],
+    }
+
+# Como copyText(): se corta al tamaño del campo y, si no es imprimible, queda
+# vacío. Un campo repetido sustituye al anterior.
+def field_text(value, max_length):
+    value = value[:max_length]
+    return bytes(value).decode("ascii") if printable(value) else ""
+
+def decode_v2(data):
+    if not valid_v2(data):
+        return None
+    length = data[1]
+    body = data[V2_HEADER:V2_HEADER + length]
+    tag = {
+        "version": 2,
+        "color": tuple(body[:3]),
+        "name": "",
+        "owner": "",
+        "flags": 0,
+        "blade_colors": [],
+    }
+    i = 3
+    while i < length and body[i] != FIELD_END:
+        field_type = body[i] >> 5
+        field_length = body[i] & 0x1F
+        value = body[i + 1:i + 1 + field_length]
+        i += 1 + field_length
+        if i > length:
+            return None
+        if field_type == FIELD_NAME:
+            tag["name"] = field_text(value, MAX_NAME)
+        elif field_type == FIELD_OWNER:
+            tag["owner"] = field_text(value, MAX_OWNER)
+        elif field_type == FIELD_FLAGS and value:
+            tag["flags"] = value[0]
+        elif field_type == FIELD_BLADE_COLOR and len(value) >= 4:
+            if len(tag["blade_colors"]) < MAX_BLADE_COLORS:
+                tag["blade_colors"].append((value[0], tuple(value[1:4])))
+    return tag
+
+# Escribe los datos del cristal. La página de cabecera va la última: si la
+# escritura se corta, el CRC no coincide y el cristal no se da por bueno.
+def ntag_write_tag(conn, data):
+    pages = [data[i:i + 4] for i in range(0, len(data), 4)]
+    for n, page in enumerate(pages[1:], start=1):
+        ntag_write_page(conn, FIRST_DATA_PAGE + n, page)
+    ntag_write_page(conn, FIRST_DATA_PAGE, pages[0])
+
+# Lee páginas desde la 4 hasta tener el cristal completo.
+def ntag_read_tag(conn):
+    data = []
+    page = FIRST_DATA_PAGE
+    while not data or (needs_more(data) and len(data) < MAX_TAG_BYTES):
+        data += list(ntag_read_page(conn, page))
+        page += 1
+    return data
+
+#################### BATCH ####################
+# Grabación de una tanda de cristales sin interfaz:
+#   python kyber_write.py --batch cristales.csv [--report resultados.csv]
+# Se usa un único contexto PC/SC y se esperan los eventos de cristal puesto y
+# retirado en vez de pausas fijas. Solo se escriben las páginas que cambian y
+# se verifica con READs de 16 bytes.
+#
+# CSV con cabecera: color,preset,owner,effect,blades,count
+#   color   "#rrggbb" o "r,g,b"
+#   effect  Default, Pulse, Breathe, Sparkle (opcional)
+#   blades  colores por filo, "2:#00ff00;3:#0000ff" (opcional)
+#   count   número de cristales iguales (opcional, 1 por defecto)
+# JSON: lista de objetos con las mismas claves; blades puede ser también una
+# lista de {"blade": 2, "color": "#00ff00"}.
+
+def parse_color(value):
+    if isinstance(value, (list, tuple)):
+        color = [int(c) for c in value]
+    else:
+        value = str(value).strip()
+        if value.startswith("#"):
+            color = [int(value[i:i + 2], 16) for i in (1, 3, 5)]
+        else:
+            color = [int(c) for c in value.split(",")]
+    if len(color) != 3 or any(c < 0 or c > 255 for c in color):
+        raise Exception(f"Color no válido: {value}")
+    return tuple(color)
+
+def parse_blades(value):
+    if not value:
+        return []
+    if isinstance(value, list):
+        return [(int(b["blade"]), parse_color(b["color"])) for b in value]
+    blades = []
+    for item in str(value).split(";"):
+        blade, color = item.split(":", 1)
+        blades.append((int(blade), parse_color(color)))
+    return blades
+
+def parse_effect(value):
+    if value in (None, ""):
+        return 0
+    if str(value).isdigit():
+        return int(value) & 0x03
+    for i, name in enumerate(CRYSTAL_EFFECTS):
+        if name.lower() == str(value).strip().lower():
+            return i
+    raise Exception(f"Efecto no válido: {value}")
+
+def load_specs(filename):
+    """Lee los cristales a grabar y devuelve una lista de (descripción, datos v2)."""
+    with open(filename, newline="", encoding="utf-8") as f:
+        if filename.lower().endswith(".json"):
+            rows = json.load(f)
+        else:
+            rows = list(csv.DictReader(f))
+
+    specs = []
+    for n, row in enumerate(rows, start=1):
+        try:
+            color = parse_color(row["color"])
+            preset = (row.get("preset") or "").strip()
+            owner = (row.get("owner") or "").strip()
+            data = encode_tag(color, preset, owner,
+                              parse_effect(row.get("effect")),
+                              parse_blades(row.get("blades")))
+            count = int(row.get("count") or 1)
+        except Exception as e:
+            raise Exception(f"Línea {n} de {filename}: {e}")
+        specs.extend([(f"{preset or 'default'} #{color[0]:02x}{color[1]:02x}{color[2]:02x}", data)] * count)
+    return specs
+
+class PCSCConnection:
+    """Conexión con un cristal dentro del contexto PC/SC de la tanda."""
+    def __init__(self, context, reader):
+        hresult, self.card, self.protocol = SCardConnect(
+            context, reader, SCARD_SHARE_SHARED, SCARD_PROTOCOL_T0 | SCARD_PROTOCOL_T1)
+        if hresult != SCARD_S_SUCCESS:
+            raise Exception(f"No se pudo conectar con el cristal: {SCardGetErrorMessage(hresult)}")
+
+    def transmit(self, apdu):
+        hresult, response = SCardTransmit(self.card, self.protocol, apdu)
+        if hresult != SCARD_S_SUCCESS:
+            raise Exception(f"Error de comunicación: {SCardGetErrorMessage(hresult)}")
+        return response[:-2], response[-2], response[-1]
+
+    def close(self):
+        SCardDisconnect(self.card, SCARD_LEAVE_CARD)
+
+class PCSCSession:
+    """Un único contexto PC/SC para toda la tanda, con espera por eventos."""
+    def __init__(self, reader_index=0):
+        hresult, self.context = SCardEstablishContext(SCARD_SCOPE_USER)
+        if hresult != SCARD_S_SUCCESS:
+            raise Exception(f"No se pudo abrir PC/SC: {SCardGetErrorMessage(hresult)}")
+        hresult, reader_list = SCardListReaders(self.context, [])
+        if hresult != SCARD_S_SUCCESS or not reader_list:
+            raise Exception("No hay lectores NFC conectados.")
+        self.reader = reader_list[reader_index]
+        self.state = SCARD_STATE_UNAWARE
+
+    def wait_card(self, present):
+        """Bloquea hasta que haya (o deje de haber) un cristal en el lector."""
+        while True:
+            hresult, states = SCardGetStatusChange(self.context, INFINITE, [(self.reader, self.state)])
+            if hresult != SCARD_S_SUCCESS:
+                raise Exception(f"Error esperando al cristal: {SCardGetErrorMessage(hresult)}")
+            _, event_state, _ = states[0]
+            self.state = event_state & ~SCARD_STATE_CHANGED
+            if bool(event_state & SCARD_STATE_PRESENT) == present:
+                return
+
+    def connect(self):
+        conn = PCSCConnection(self.context, self.reader)
+        # Desactivar el buzzer del ACR122U.
+        try:
+            conn.transmit([0xFF, 0x00, 0x52, 0x00, 0x00])
+        except Exception:
+            pass
+        return conn
+
+    def close(self):
+        SCardReleaseContext(self.context)
+
+# READ de NTAG2xx: 4 páginas (16 bytes) por comando.
+def ntag_read16(conn, page):
+    resp, sw1, sw2 = conn.transmit([0xFF, 0xB0, 0x00, page, 0x10])
+    if (sw1, sw2) != (0x90, 0x00) or len(resp) < 16:
+        raise Exception(f"Error al leer página {page}: SW={sw1:02X}{sw2:02X}")
+    return list(resp[:16])
+
+def ntag_read_bytes(conn, length):
+    data = []
+    page = FIRST_DATA_PAGE
+    while len(data) < length:
+        data += ntag_read16(conn, page)
+        page += 4
+    return data[:length]
+
+def provision_tag(conn, data):
+    """Escribe solo las páginas distintas (la cabecera la última) y verifica.
+    Devuelve el número de páginas escritas."""
+    current = ntag_read_bytes(conn, len(data))
+    changed = [n for n in range(len(data) // 4) if current[n * 4:n * 4 + 4] != data[n * 4:n * 4 + 4]]
+    for n in sorted(changed, key=lambda n: n == 0):
+        ntag_write_page(conn, FIRST_DATA_PAGE + n, data[n * 4:n * 4 + 4], settle=0, verbose=False)
+
+    if ntag_read_bytes(conn, len(data)) != data:
+        raise Exception("La verificación no coincide con lo escrito.")
+    return len(changed)
+
+def run_batch(spec_file, report_file=None, reader_index=0):
+    specs = load_specs(spec_file)
+    print(f"{len(specs)} cristales en {spec_file}")
+
+    session = PCSCSession(reader_index)
+    results = []
+    failures = {}
+    start = None
+    index = 0
+    try:
+        while index < len(specs):
+            name, data = specs[index]
+            print(f"[{index + 1}/{len(specs)}] Pon el cristal: {name}")
+            session.wait_card(True)
+            if start is None:
+                start = time.monotonic()
+
+            t0 = time.monotonic()
+            uid = ""
+            try:
+                conn = session.connect()
+                try:
+                    uid = toHexString(ntag_get_uid(conn))
+                    pages = provision_tag(conn, data)
+                finally:
+                    conn.close()
+                elapsed = time.monotonic() - t0
+                results.append((index + 1, name, uid, "OK", pages, elapsed, ""))
+                print(f"    OK {uid}: {pages} páginas escritas en {elapsed:.2f}s. Retira el cristal.")
+                index += 1
+            except Exception as e:
+                elapsed = time.monotonic() - t0
+                reason = str(e)
+                failures[reason] = failures.get(reason, 0) + 1
+                results.append((index + 1, name, uid, "FAIL", 0, elapsed, reason))
+                print(f"    FALLO {uid}: {reason}. Retira el cristal para reintentar.")
+
+            session.wait_card(False)
+    except KeyboardInterrupt:
+        print("\nTanda interrumpida.")
+    finally:
+        session.close()
+
+    # Resumen.
+    ok = sum(1 for r in results if r[3] == "OK")
+    total_time = time.monotonic() - start if start is not None else 0
+    print("\n========== RESUMEN ==========")
+    print(f"Cristales grabados: {ok}/{len(specs)}, intentos fallidos: {len(results) - ok}")
+    if total_time > 0:
+        print(f"Ritmo: {ok * 60 / total_time:.1f} cristales/minuto ({total_time:.0f}s)")
+    if ok:
+        print(f"Tiempo medio por cristal en el lector: {sum(r[5] for r in results if r[3] == 'OK') / ok:.2f}s")
+    for reason, count in sorted(failures.items(), key=lambda f: -f[1]):
+        print(f"  {count} x {reason}")
+
+    if report_file:
+        with open(report_file, "w", newline="", encoding="utf-8") as f:
+            writer = csv.writer(f)
+            writer.writerow(["spec", "name", "uid", "result", "pages_written", "seconds", "error"])
+            for r in results:
+                writer.writerow([r[0], r[1], r[2], r[3], r[4], f"{r[5]:.3f}", r[6]])
+        print(f"Informe guardado en {report_file}")
+
+    return ok == len(specs)
+
+#################### GUI ####################
+
+class App:
+    def __init__(self, root):
+        self.root = root
+        self.root.title("Arkaivos Kyber Lab")
+
+        self.color_rgb = (255, 255, 255)
+        self.text_var = StringVar()
+        self.owner_var = StringVar()
+        self.effect_var = StringVar(value=CRYSTAL_EFFECTS[0])
+        self.color_hex_var = StringVar(value="#000000")
+        self.firma_valida = IntVar(value=0)
+
+        # Cargar imagen base.
+        try:
+            self.base_image = Image.open("kyber.png").convert("RGBA")
+            # Redimensionar manteniendo aspect ratio 2:3.
+            target_height = 120
+            target_width = int(target_height * 2 / 3)
+            self.base_image = self.base_image.resize((target_width, target_height), Image.LANCZOS)
+        except Exception as e:
+            messagebox.showerror("Error", f"No se pudo cargar la imagen: {e}")
+            self.base_image = None
+
+        self.build_ui()
+
+    def build_ui(self):
+        frm = ttk.Frame(self.root, padding=10)
+        frm.grid(row=0, column=0)
+
+        # Configurar pesos de columnas para distribuir mejor el espacio.
+        frm.columnconfigure(1, weight=0)
+        frm.columnconfigure(2, weight=1)
+
+        # Color selector.
+        ttk.Label(frm, text="Color RGB:").grid(row=0, column=0, sticky="w", pady=(0, 8))
+        ttk.Entry(frm, textvariable=self.color_hex_var, width=10).grid(row=0, column=1, sticky="w", padx=5, pady=(0, 8))
+        ttk.Button(frm, text="Select color", command=self.choose_color).grid(row=0, column=2, sticky="w", pady=(0, 8))
+
+        self.style_label_color = "UIDLabel.TLabel"
+        self.style = ttk.Style()
+        self.style.configure(self.style_label_color, foreground="#FFFFFF")  # color inicial negro
+
+        # Color preview
+        if self.base_image:
+            self.color_preview = ttk.Label(frm)
+            self.color_preview.grid(row=0, column=3, padx=(30, 20), pady=(10, 0),rowspan= 3, sticky="n")
+            self.update_color_preview()
+        else:
+            self.color_preview = Canvas(frm, width=40, height=20, bg="#000000")
+            self.color_preview.grid(row=0, column=3, padx=10, sticky="e")
+
+        # Text
+        ttk.Label(frm, text="Preset: ").grid(row=1, column=0, sticky="w", pady=(0, 20))
+        vcmd = (frm.register(self.validate_text), "%P")
+
+        self.entry_text = ttk.Entry(
+            frm,
+            textvariable=self.text_var,
+            width=25,
+            validate="key",
+            validatecommand=vcmd
+        )
+        self.entry_text.grid(row=1, column=1, columnspan=2, sticky="ew", padx=5, pady=(0, 20))
+
+        # Propietario.
+        ttk.Label(frm, text="Attuned to:").grid(row=2, column=0, sticky="w", padx=(0, 5), pady=(0, 20))
+        vcmd_owner = (frm.register(self.validate_owner), "%P")
+
+        self.entry_owner = ttk.Entry(
+            frm,
+            textvariable=self.owner_var,
+            width=25,
+            validate="key",
+            validatecommand=vcmd_owner
+        )
+        self.entry_owner.grid(row=2, column=1, columnspan=2, sticky="ew", padx=(5, 5), pady=(0, 20))
+
+        # Efecto del LED del cristal.
+        ttk.Label(frm, text="Effect:").grid(row=3, column=0, sticky="w", pady=(0, 20))
+        ttk.Combobox(
+            frm,
+            textvariable=self.effect_var,
+            values=CRYSTAL_EFFECTS,
+            state="readonly",
+            width=12
+        ).grid(row=3, column=1, columnspan=2, sticky="w", padx=5, pady=(0, 20))
+
+        # Botones.
+        ttk.Button(frm, text="Write Crystal", command=self.write_tag).grid(row=4, column=0, columnspan=1, pady=(0, 0), sticky="ew", padx=(0, 2))
+        ttk.Button(frm, text="Read Crystal", command=self.read_tag).grid(row=4, column=1, columnspan=2, pady=(0, 0), sticky="ew", padx=(2, 0))
+        # ttk.Button(frm, text="Ver Config/Bloqueo", command=self.check_lock).grid(row=2, column=2, pady=10)
+
+        self.uid_var = ttk.StringVar(value="Crystal UID")
+        self.uid_label = ttk.Label(
+            frm,
+            textvariable=self.uid_var,
+            style=self.style_label_color,
+            bootstyle="info"
+        )
+        self.uid_label.grid(row=4, column=3, columnspan=1, pady=(0, 0), padx=(5, 0), sticky="s")
+
+
+    def validate_text(self, new_value):
+        return len(new_value) <= MAX_NAME
+
+    def validate_owner(self, new_value):
+        return len(new_value) <= MAX_OWNER
+
+    def choose_color(self):
+        color = colorchooser.askcolor()[0]
+        if color:
+            r, g, b = int(color[0]), int(color[1]), int(color[2])
+            self.color_rgb = (r, g, b)
+            hexcode = "#%02x%02x%02x" % (r, g, b)
+            self.color_hex_var.set(hexcode)
+            self.update_color_preview()
+
+    def update_color_preview(self):
+        r, g, b = self.color_rgb
+        hex_color = "#%02x%02x%02x" % (r, g, b)
+        self.style.configure(self.style_label_color, foreground=hex_color)
+
+        if not self.base_image:
+            # Fallback...
+            return
+        
+        # Trabajar con RGBA
+        img_rgba = self.base_image.copy()
+        pixels = img_rgba.load()
+        width, height = img_rgba.size
+        
+        import colorsys
+        h_target, s_target, v_target = colorsys.rgb_to_hsv(r/255.0, g/255.0, b/255.0)
+        
+        for y in range(height):
+            for x in range(width):
+                pixel = pixels[x, y]
+                gray = pixel[0]  # Canal R (en escala de grises da igual cual coger).
+                alpha = pixel[3]  # Canal alfa.
+                
+                v_original = gray / 255.0
+                new_r, new_g, new_b = colorsys.hsv_to_rgb(h_target, s_target, v_original)
+                
+                pixels[x, y] = (
+                    int(new_r * 255),
+                    int(new_g * 255),
+                    int(new_b * 255),
+                    alpha  # Mantener transparencia original.
+                )
+        
+        self.photo = ImageTk.PhotoImage(img_rgba)
+        self.color_preview.config(image=self.photo)
+        self.color_preview.image = self.photo
+
+    ################ WRITE ################
+
+    def write_tag(self):
+        print("\n========== INICIANDO ESCRITURA ==========")
+        
+        # Get color
+        text = self.text_var.get()[:MAX_NAME]
+        owner = self.owner_var.get()[:MAX_OWNER]
+        flags = CRYSTAL_EFFECTS.index(self.effect_var.get())
+        r, g, b = self.color_rgb
+
+        print(f"Color a escribir: RGB({r}, {g}, {b})")
+        print(f"Texto a escribir: '{text}' (longitud: {len(text)})")
+        print(f"Propietario a escribir: '{owner}' (longitud: {len(owner)})")
+
+        try:
+            data = encode_tag((r, g, b), text, owner, flags)
+        except Exception as e:
+            messagebox.showerror("Error", str(e))
+            return
+        print(f"Cristal v2: {len(data)} bytes -> HEX: {toHexString(data)}")
+
+        max_attempts = 2
+        for global_attempt in range(max_attempts):
+            try:
+                if global_attempt > 0:
+                    print(f"\n[GLOBAL] Reintento completo {global_attempt + 1}/{max_attempts}")
+                    time.sleep(0.3)
+                
+                conn = connect_reader()
+
+                ntag_write_tag(conn, data)
+
+                print("========== ESCRITURA COMPLETADA ==========\n")
+
+                # Verificación inmediata
+                print("========== VERIFICANDO ESCRITURA ==========")
+                time.sleep(0.2)
+                verify = ntag_read_tag(conn)
+                print(f"Verificación: {toHexString(verify)}")
+                if verify[:len(data)] != data:
+                    raise Exception("La verificación no coincide con lo escrito.")
+                print("========== VERIFICACIÓN COMPLETADA ==========\n")
+                
+                messagebox.showinfo("OK", "Cristal Kyber generado correctamente.")
+                return
+                
+            except Exception as e:
+                print(f"[GLOBAL] Error en intento {global_attempt + 1}: {e}")
+                if global_attempt == max_attempts - 1:
+                    messagebox.showerror("Error", str(e))
+                    return
+
+    ################ READ ################
+
+    def read_tag(self):
+        print("\n========== INICIANDO LECTURA ==========")
+        try:
+            conn = connect_reader()
+            uid = ntag_get_uid(conn)
+            print("UID del tag:", toHexString(uid))
+            uid_hex = toHexString(uid)
+            self.uid_var.set(f"{uid_hex}")
+        except Exception as e:
+            messagebox.showerror("Error", str(e))
+            return
+
+        try:
+            data = ntag_read_tag(conn)
+        except Exception as e:
+            messagebox.showerror("Error", str(e))
+            return
+
+        tag = decode_tag(data)
+        if tag is None:
+            messagebox.showerror("Error", "Los datos del cristal no son válidos.")
+            return
+
+        r, g, b = tag["color"]
+        text = tag["name"]
+        owner = tag["owner"]
+        effect = tag["flags"] & 0x03
+
+        self.firma_valida.set(0)
+
+        print(f"Formato: v{tag['version']}")
+        print(f"Color leído: RGB({r}, {g}, {b})")
+        print(f"Texto leído: '{text}'")
+        print(f"Propietario leído: '{owner}'")
+        for blade, color in tag["blade_colors"]:
+            print(f"Color del filo {blade}: RGB{color}")
+        print("========== LECTURA COMPLETADA ==========\n")
+
+        self.color_rgb = (r, g, b)
+        self.color_hex_var.set("#%02x%02x%02x" % (r, g, b))
+        self.update_color_preview()
+
+        self.text_var.set(text)
+        self.owner_var.set(owner)
+        self.effect_var.set(CRYSTAL_EFFECTS[effect])
+
+    ################ CHECK LOCK ################
+    """
+    def check_lock(self):
+        print("\n========== VERIFICANDO CONFIGURACIÓN ==========")
+        try:
+            conn = connect_reader()
+        except Exception as e:
+            messagebox.showerror("Error", str(e))
+            return
+
+        try:
+            # Página 2: Lock bytes
+            p2 = ntag_read_page(conn, 2)
+            print(f"Página 2 (Lock bytes): {list(p2)} -> {toHexString(p2)}")
+            
+            # Página 3: CC (Capability Container)
+            p3 = ntag_read_page(conn, 3)
+            print(f"Página 3 (CC): {list(p3)} -> {toHexString(p3)}")
+            
+            # Páginas 40-41: Dynamic lock bytes (NTAG213)
+            p40 = ntag_read_page(conn, 40)
+            print(f"Página 40 (Dynamic Lock): {list(p40)} -> {toHexString(p40)}")
+            
+            p41 = ntag_read_page(conn, 41)
+            print(f"Página 41 (CFG0): {list(p41)} -> {toHexString(p41)}")
+            
+            p42 = ntag_read_page(conn, 42)
+            print(f"Página 42 (CFG1): {list(p42)} -> {toHexString(p42)}")
+            
+            # Análisis
+            info = "CONFIGURACIÓN DEL TAG:\n\n"
+            info += f"Lock bytes (P2): {toHexString(p2)}\n"
+            info += f"Capability Container (P3): {toHexString(p3)}\n"
+            info += f"Dynamic Lock (P40): {toHexString(p40)}\n"
+            info += f"CFG0 (P41): {toHexString(p41)}\n"
+            info += f"CFG1 (P42): {toHexString(p42)}\n\n"
+            
+            # Interpretación de lock bytes
+            if p2[2] != 0x00 or p2[3] != 0x00:
+                info += "- PÁGINAS BLOQUEADAS detectadas en P2\n"
+            if p40[0] != 0x00 or p40[1] != 0x00 or p40[2] != 0x00:
+                info += "- PÁGINAS BLOQUEADAS detectadas en P40\n"
+            
+            # AUTH0 (primer byte de CFG1) - primera página que requiere autenticación
+            auth0 = p42[3]
+            info += f"\nAUTH0 = {auth0} (0x{auth0:02X})\n"
+            if auth0 <= 8:
+                info += f"- Las páginas {auth0}-42 requieren autenticación para escritura\n"
+            
+            print(info)
+            messagebox.showinfo("Configuración del Tag", info)
+            
+        except Exception as e:
+            messagebox.showerror("Error", str(e))
+            print(f"Error leyendo configuración: {e}")
+        
+        print("========== VERIFICACIÓN COMPLETADA ==========\n")
+    """
+
+#################### MAIN ####################
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Arkaivos Kyber Lab")
+    parser.add_argument("--batch", metavar="FICHERO", help="graba sin interfaz los cristales de un CSV o JSON")
+    parser.add_argument("--report", metavar="FICHERO", help="guarda un CSV con el resultado de cada cristal")
+    parser.add_argument("--reader", type=int, default=0, help="índice del lector PC/SC (0 por defecto)")
+    args = parser.parse_args()
+
+    if args.batch:
+        try:
+            sys.exit(0 if run_batch(args.batch, args.report, args.reader) else 1)
+        except Exception as e:
+            print(f"Error: {e}")
+            sys.exit(1)
+
+    root = ttk.Window(themename="darkly") 
+    app = App(root)
     root.mainloop()
\ No newline at end of file
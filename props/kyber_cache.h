@@ -0,0 +1,216 @@
+#ifndef PROPS_KYBER_CACHE_H
+#define PROPS_KYBER_CACHE_H
+
+// =========================================
+// KYBER CACHE - Cristales conocidos por UID
+// =========================================
+// Guarda el resultado decodificado de los últimos cristales (color, preset,
+// propietario, flags y colores por filo) indexado por UID. Un cristal
+// conocido se aplica con la lectura del UID y una búsqueda en RAM, sin leer
+// sus páginas. Junto al índice del preset va el hash de su nombre, para
+// comprobar antes de aplicarlo que sigue siendo el mismo preset.
+// Se mantiene ordenada de más a menos reciente (LRU) y se guarda en la SD en
+// un formato binario compacto.
+
+#ifndef KYBER_CACHE_SIZE
+#define KYBER_CACHE_SIZE 8
+#endif
+
+class KyberCrystalCache {
+public:
+  static constexpr uint8_t MAX_UID = 7;
+  static constexpr uint8_t OWNER_LENGTH = KyberTag::OWNER_LENGTH;
+
+  struct Entry {
+    uint8_t uidLength;
+    uint8_t uid[MAX_UID];
+    uint8_t color[3];
+    uint16_t preset;
+    uint32_t presetHash;       // KyberPresetMatch::nameHash() del nombre del preset.
+    char owner[OWNER_LENGTH];  // Sin terminador si ocupa todos los bytes.
+    uint8_t flags;
+    uint8_t bladeColorCount;
+    KyberBladeColor bladeColors[KYBER_TAG_BLADE_COLORS];
+  };
+
+  KyberCrystalCache() : count_(0), dirty_(false) {}
+
+  // Busca un UID y, si está, lo pasa a la posición más reciente.
+  const Entry* lookup(const uint8_t* uid, uint8_t uidLength) {
+    int i = find(uid, uidLength);
+    if (i < 0) return nullptr;
+    touch(i);
+    return &entries_[0];
+  }
+
+  // Inserta o actualiza un cristal. Si está llena se descarta el menos reciente.
+  void store(const uint8_t* uid, uint8_t uidLength, uint16_t preset, uint32_t presetHash, const KyberTag& tag) {
+    if (uidLength == 0 || uidLength > MAX_UID) return;
+
+    int i = find(uid, uidLength);
+    if (i < 0) {
+      if (count_ < KYBER_CACHE_SIZE) count_++;
+      i = count_ - 1;
+    }
+    touch(i);
+
+    Entry& e = entries_[0];
+    e.uidLength = uidLength;
+    memset(e.uid, 0, sizeof(e.uid));
+    memcpy(e.uid, uid, uidLength);
+    memcpy(e.color, tag.color, sizeof(e.color));
+    e.preset = preset;
+    e.presetHash = presetHash;
+    // Campo de ancho fijo: sin terminador si el nombre lo llena, ceros detrás si no.
+    size_t ownerLength = strnlen(tag.owner, sizeof(e.owner));
+    memcpy(e.owner, tag.owner, ownerLength);
+    memset(e.owner + ownerLength, 0, sizeof(e.owner) - ownerLength);
+    e.flags = tag.flags;
+    e.bladeColorCount = tag.bladeColorCount;
+    memcpy(e.bladeColors, tag.bladeColors, sizeof(e.bladeColors));
+    dirty_ = true;
+  }
+
+  // Olvida un cristal (por ejemplo, si ha dejado de ser válido).
+  void remove(const uint8_t* uid, uint8_t uidLength) {
+    int i = find(uid, uidLength);
+    if (i < 0) return;
+    memmove(entries_ + i, entries_ + i + 1, (count_ - i - 1) * sizeof(Entry));
+    count_--;
+    dirty_ = true;
+  }
+
+  void clear() {
+    count_ = 0;
+    dirty_ = true;
+  }
+
+  uint8_t size() const { return count_; }
+  bool dirty() const { return dirty_; }
+
+#ifdef ENABLE_SD
+  // Formato: 'K' 'C' versión número, entradas de RECORD_SIZE bytes y un byte de suma.
+  // Una caché de otra versión se descarta.
+  bool load(const char* filename) {
+    count_ = 0;
+    dirty_ = false;
+    if (!LSFS::Exists(filename)) return false;
+
+    File f = LSFS::Open(filename);
+    if (!f) return false;
+
+    uint8_t header[4];
+    bool ok = f.read(header, sizeof(header)) == sizeof(header) &&
+              header[0] == 'K' && header[1] == 'C' && header[2] == VERSION &&
+              header[3] <= KYBER_CACHE_SIZE;
+    uint8_t sum = 0;
+    if (ok) {
+      for (uint8_t i = 0; i < header[3] && ok; i++) {
+        uint8_t record[RECORD_SIZE];
+        ok = f.read(record, sizeof(record)) == sizeof(record);
+        if (ok) {
+          for (uint8_t j = 0; j < sizeof(record); j++) sum += record[j];
+          unpack(record, entries_[i]);
+          ok = entries_[i].uidLength > 0 && entries_[i].uidLength <= MAX_UID &&
+               entries_[i].bladeColorCount <= KYBER_TAG_BLADE_COLORS;
+        }
+      }
+    }
+    uint8_t check;
+    ok = ok && f.read(&check, 1) == 1 && check == sum;
+    f.close();
+
+    if (ok) count_ = header[3];
+    return ok;
+  }
+
+  bool save(const char* filename) {
+    File f = LSFS::OpenForWrite(filename);
+    if (!f) return false;
+
+    uint8_t header[4] = { 'K', 'C', VERSION, count_ };
+    f.write(header, sizeof(header));
+    uint8_t sum = 0;
+    for (uint8_t i = 0; i < count_; i++) {
+      uint8_t record[RECORD_SIZE];
+      pack(entries_[i], record);
+      for (uint8_t j = 0; j < sizeof(record); j++) sum += record[j];
+      f.write(record, sizeof(record));
+    }
+    f.write(&sum, 1);
+    f.close();
+    dirty_ = false;
+    return true;
+  }
+#endif
+
+private:
+  static constexpr uint8_t VERSION = 3;
+  static constexpr uint8_t RECORD_SIZE = 1 + MAX_UID + 3 + 2 + 4 + OWNER_LENGTH + 2 + 4 * KYBER_TAG_BLADE_COLORS;
+
+  int find(const uint8_t* uid, uint8_t uidLength) const {
+    for (uint8_t i = 0; i < count_; i++) {
+      if (entries_[i].uidLength == uidLength && memcmp(entries_[i].uid, uid, uidLength) == 0) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  // Mueve la entrada i al principio desplazando las más recientes.
+  void touch(int i) {
+    if (i == 0) return;
+    Entry e = entries_[i];
+    memmove(entries_ + 1, entries_, i * sizeof(Entry));
+    entries_[0] = e;
+  }
+
+  static void pack(const Entry& e, uint8_t* record) {
+    uint8_t* p = record;
+    *p++ = e.uidLength;
+    memcpy(p, e.uid, MAX_UID);
+    p += MAX_UID;
+    memcpy(p, e.color, 3);
+    p += 3;
+    *p++ = e.preset;
+    *p++ = e.preset >> 8;
+    for (uint8_t i = 0; i < 4; i++) *p++ = e.presetHash >> (8 * i);
+    memcpy(p, e.owner, OWNER_LENGTH);
+    p += OWNER_LENGTH;
+    *p++ = e.flags;
+    *p++ = e.bladeColorCount;
+    for (uint8_t i = 0; i < KYBER_TAG_BLADE_COLORS; i++) {
+      *p++ = e.bladeColors[i].blade;
+      memcpy(p, e.bladeColors[i].color, 3);
+      p += 3;
+    }
+  }
+
+  static void unpack(const uint8_t* record, Entry& e) {
+    const uint8_t* p = record;
+    e.uidLength = *p++;
+    memcpy(e.uid, p, MAX_UID);
+    p += MAX_UID;
+    memcpy(e.color, p, 3);
+    p += 3;
+    e.preset = p[0] | (p[1] << 8);
+    p += 2;
+    e.presetHash = 0;
+    for (uint8_t i = 0; i < 4; i++) e.presetHash |= (uint32_t)*p++ << (8 * i);
+    memcpy(e.owner, p, OWNER_LENGTH);
+    p += OWNER_LENGTH;
+    e.flags = *p++;
+    e.bladeColorCount = *p++;
+    for (uint8_t i = 0; i < KYBER_TAG_BLADE_COLORS; i++) {
+      e.bladeColors[i].blade = *p++;
+      memcpy(e.bladeColors[i].color, p, 3);
+      p += 3;
+    }
+  }
+
+  Entry entries_[KYBER_CACHE_SIZE];
+  uint8_t count_;
+  bool dirty_;
+};
+
+#endif
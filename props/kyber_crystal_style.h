@@ -0,0 +1,216 @@
+#ifndef PROPS_KYBER_CRYSTAL_STYLE_H
+#define PROPS_KYBER_CRYSTAL_STYLE_H
+
+// =========================================
+// KYBER CRYSTAL STYLE - LEDs de la cámara del cristal
+// =========================================
+// Estilo que se monta en blade2 para iluminar el cristal. Al armarlo se
+// precalcula una tabla con el color del cristal en 64 niveles de brillo
+// (con corrección de gamma), de forma que cada frame solo indexa la tabla y
+// rellena todos los LEDs de la cámara en un único bucle, sin divisiones.
+// Cuando termina el efecto deja los LEDs en negro una vez y ya no vuelve a
+// pintar.
+// Es del heap, como los estilos del preset, y el estilo de blade2 que tapa
+// pasa a ser suyo: si ProffieOS libera los estilos (FreeBladeStyles hace
+// delete) con él montado, se destruyen los dos. Hay como mucho uno a la vez,
+// y instance() deja de devolverlo en cuanto se destruye.
+
+#define CRYSTAL_PATTERN_PULSE   0  // Pulso sinusoidal de 1,5 s, todos los LEDs a la vez.
+#define CRYSTAL_PATTERN_BREATHE 1  // Respiración lenta de 4 s sin llegar a apagarse.
+#define CRYSTAL_PATTERN_SPARKLE 2  // Brillo de fondo con destellos aleatorios por LED.
+
+#ifndef CRYSTAL_PATTERN
+#define CRYSTAL_PATTERN CRYSTAL_PATTERN_PULSE
+#endif
+
+// LEDs de la cámara con estado propio en el patrón de destellos.
+#ifndef KYBER_CRYSTAL_MAX_LEDS
+#define KYBER_CRYSTAL_MAX_LEDS 16
+#endif
+
+class CrystalLEDStyle : public BladeStyle {
+public:
+  static constexpr uint8_t LEVELS = 64;
+
+  CrystalLEDStyle() : covered_(nullptr), pattern_(CRYSTAL_PATTERN), duration_(0), startTime_(0),
+                      lastFrame_(0), phase_(0), phaseStep_(0), fadeStart_(0),
+                      fadeScale_(0), finished_(false), rendered_(false), firstFrame_(0) {
+    instance_ = this;
+  }
+
+  ~CrystalLEDStyle() override {
+    delete covered_;
+    if (instance_ == this) instance_ = nullptr;
+  }
+
+  // El estilo vivo, o nullptr si no hay ninguno.
+  static CrystalLEDStyle* instance() { return instance_; }
+
+  // Se monta en 'blade' encima de su estilo, que pasa a ser suyo.
+  void cover(BladeBase* blade) {
+    covered_ = blade->UnSetStyle();
+    blade->SetStyle(this);
+  }
+
+  // Se desmonta de 'blade' y le devuelve el estilo que tapaba.
+  void uncover(BladeBase* blade) {
+    blade->UnSetStyle();
+    blade->SetStyle(covered_);
+    covered_ = nullptr;
+  }
+
+  // Cambia color, duración y patrón y reinicia la animación.
+  // Toda la aritmética costosa se hace aquí, una vez por cristal.
+  void arm(uint16_t r, uint16_t g, uint16_t b, uint32_t durationMs,
+           uint8_t pattern = CRYSTAL_PATTERN) {
+    pattern_ = pattern;
+    duration_ = durationMs;
+    startTime_ = millis();
+    lastFrame_ = startTime_;
+    phase_ = 0;
+    finished_ = false;
+    rendered_ = false;
+    firstFrame_ = 0;
+
+    // Nivel i -> brillo (i / 63)^2, aproximación de gamma 2.
+    for (uint32_t i = 0; i < LEVELS; i++) {
+      uint32_t scale = (i * i * 65535) / ((LEVELS - 1) * (LEVELS - 1));
+      lut_[i] = Color16((r * scale) >> 16, (g * scale) >> 16, (b * scale) >> 16);
+    }
+
+    // La onda tiene 64 pasos; el acumulador de fase avanza en unidades de 1/65536 de paso.
+    uint32_t period = pattern_ == CRYSTAL_PATTERN_BREATHE ? 4000 : 1500;
+    phaseStep_ = ((uint32_t)LEVELS << 16) / period;
+
+    // Fundido final de 1 s (o toda la duración si es más corta).
+    fadeStart_ = duration_ > 1000 ? duration_ - 1000 : 0;
+    fadeScale_ = duration_ > fadeStart_ ? 65536 / (duration_ - fadeStart_) : 0;
+
+    for (uint8_t i = 0; i < KYBER_CRYSTAL_MAX_LEDS; i++) sparkle_[i] = BASE_LEVEL;
+  }
+
+  bool isFinished() const {
+    if (duration_ == 0) return false; // Permanente nunca termina.
+    return (millis() - startTime_) >= duration_; // Termina al finalizar la duración.
+  }
+
+  bool isTemporaryActive() const {
+      // Indica si ha terminado la animación de feedback del cristal cuando esta no es ilimitada.
+      return duration_ > 0 && (millis() - startTime_) < duration_;
+  }
+
+  bool hasRendered() const { return rendered_; }
+  uint32_t firstFrameMicros() const { return firstFrame_; }
+
+  void run(BladeBase* blade) override {
+    KYBER_TIME_PHASE(KYBER_PHASE_LED);
+
+    // Efecto terminado y LEDs ya en negro: nada que pintar.
+    if (finished_) return;
+
+    uint32_t now = millis();
+    uint32_t elapsed = now - startTime_;
+    uint32_t dt = now - lastFrame_;
+    lastFrame_ = now;
+    int num_leds = blade->num_leds();
+
+    if (!rendered_) {
+      rendered_ = true;
+      firstFrame_ = micros();
+    }
+
+    // Apagado - todos los LEDs del cristal en negro, una sola vez.
+    if (duration_ != 0 && elapsed >= duration_) {
+      Color16 black(0, 0, 0);
+      for (int i = 0; i < num_leds; i++) blade->set(i, black);
+      finished_ = true;
+      return;
+    }
+
+    // Factor de fundido en 1/65536 (65536 = sin fundido).
+    uint32_t fade = 65536;
+    if (duration_ != 0 && elapsed >= fadeStart_) {
+      fade = (duration_ - elapsed) * fadeScale_;
+    }
+
+    phase_ += dt * phaseStep_;
+    uint8_t wave = WAVE[(phase_ >> 16) & (LEVELS - 1)];
+
+    switch (pattern_) {
+      case CRYSTAL_PATTERN_SPARKLE: {
+        // Un destello nuevo de vez en cuando; cada LED vuelve al fondo poco a poco.
+        if ((uint32_t)random(256) < dt * 2) {
+          sparkle_[random(num_leds) % KYBER_CRYSTAL_MAX_LEDS] = LEVELS - 1;
+        }
+        uint8_t decay = dt / 4 + 1;
+        for (int i = 0; i < num_leds; i++) {
+          uint8_t& level = sparkle_[i % KYBER_CRYSTAL_MAX_LEDS];
+          if (i < KYBER_CRYSTAL_MAX_LEDS && level > BASE_LEVEL) {
+            level = level - BASE_LEVEL > decay ? level - decay : BASE_LEVEL;
+          }
+          blade->set(i, lut_[(level * fade) >> 16]);
+        }
+        return;
+      }
+
+      case CRYSTAL_PATTERN_BREATHE:
+        // Entre un cuarto y el máximo del brillo.
+        fill(blade, num_leds, lut_[(((wave * 3) / 4 + LEVELS / 4) * fade) >> 16]);
+        return;
+
+      default:
+        fill(blade, num_leds, lut_[(wave * fade) >> 16]);
+        return;
+    }
+  }
+
+  // IMPORTANTE: Solo mantener con energía mientras está activo.
+  // Si se deja con energía siempre, produce sobrecalentamiento y consume más batería.
+  bool NoOnOff() override {
+    if (duration_ == 0) {
+      return true; // Permanente, con energía mientras dure el estilo.
+    }
+
+    uint32_t elapsed = millis() - startTime_;
+    return elapsed < duration_; // Al finalizar la duración, permite desconectar el cristal de la batería.
+  }
+
+  bool IsHandled(HandledFeature feature) override { return false; }
+
+private:
+  static constexpr uint8_t BASE_LEVEL = 24;
+
+  // Un periodo de coseno en 64 pasos, de 63 a 0 y vuelta (empieza encendido).
+  static constexpr uint8_t WAVE[LEVELS] = {
+    63, 63, 62, 62, 61, 59, 58, 56, 54, 51, 49, 46, 44, 41, 38, 35,
+    32, 28, 25, 22, 19, 17, 14, 12, 9, 7, 5, 4, 2, 1, 1, 0,
+    0, 0, 1, 1, 2, 4, 5, 7, 9, 12, 14, 17, 19, 22, 25, 28,
+    31, 35, 38, 41, 44, 46, 49, 51, 54, 56, 58, 59, 61, 62, 62, 63,
+  };
+
+  static void fill(BladeBase* blade, int num_leds, const Color16& c) {
+    for (int i = 0; i < num_leds; i++) blade->set(i, c);
+  }
+
+  static CrystalLEDStyle* instance_;
+
+  BladeStyle* covered_;
+  Color16 lut_[LEVELS];
+  uint8_t sparkle_[KYBER_CRYSTAL_MAX_LEDS];
+  uint8_t pattern_;
+  uint32_t duration_;
+  uint32_t startTime_;
+  uint32_t lastFrame_;
+  uint32_t phase_;
+  uint32_t phaseStep_;
+  uint32_t fadeStart_;
+  uint32_t fadeScale_;
+  bool finished_;
+  bool rendered_;
+  uint32_t firstFrame_;
+};
+
+constexpr uint8_t CrystalLEDStyle::WAVE[CrystalLEDStyle::LEVELS];
+CrystalLEDStyle* CrystalLEDStyle::instance_ = nullptr;
+
+#endif
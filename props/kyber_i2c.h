@@ -0,0 +1,161 @@
+#ifndef PROPS_KYBER_I2C_H
+#define PROPS_KYBER_I2C_H
+
+// =========================================
+// KYBER I2C - Reparto del bus entre el NFC y el IMU
+// =========================================
+// El PN532 comparte el bus con el acelerómetro/giróscopo. Cada transferencia
+// del PN532 (como mucho una trama de 32 bytes) pide paso antes de empezar y
+// toma el cerrojo del bus de ProffieOS (I2CLock(), common/i2cdevice.h), el
+// mismo que usan los drivers del IMU: una transferencia nunca empieza en
+// medio de una lectura del IMU. Si el cerrojo está ocupado, la transferencia
+// se deja para una pasada posterior de Loop(); nunca se espera.
+// Además, solo se concede si termina antes de la siguiente muestra del IMU,
+// que se predice con el periodo de las llamadas a SB_Accel, para no retrasar
+// la muestra siguiente. Si una transferencia no cabe nunca entre dos
+// muestras, solo se permite justo después de una.
+// Las lecturas del IMU las hace ProffieOS y no pasan por aquí: su ocupación
+// se estima con KYBER_MOTION_READ_BYTES por muestra.
+
+#include "../common/i2cdevice.h"
+
+// Velocidad del bus, para estimar cuánto dura una transferencia.
+#ifndef KYBER_I2C_HZ
+#define KYBER_I2C_HZ 400000
+#endif
+
+// Margen que se deja libre antes de la siguiente muestra del IMU.
+#ifndef KYBER_I2C_GUARD_US
+#define KYBER_I2C_GUARD_US 200
+#endif
+
+// Bytes de una lectura del IMU (acelerómetro y giróscopo).
+#ifndef KYBER_MOTION_READ_BYTES
+#define KYBER_MOTION_READ_BYTES 12
+#endif
+
+class KyberI2CScheduler {
+public:
+  enum Client : uint8_t {
+    CLIENT_NFC,
+    CLIENT_MOTION,
+    CLIENT_COUNT
+  };
+
+  KyberI2CScheduler() : lastMotion_(0), period_(0), motionSamples_(0), start_(0) { reset(); }
+
+  void reset() {
+    memset(stats_, 0, sizeof(stats_));
+    windowStart_ = micros();
+  }
+
+  // Dirección, datos y ACK: 9 bits por byte, más el arranque y la parada.
+  static uint32_t transferMicros(uint8_t bytes) {
+    return (bytes + 1) * 9 * 1000000UL / KYBER_I2C_HZ + 50;
+  }
+
+  // Llega una muestra del IMU (SB_Accel).
+  void motionSample() {
+    uint32_t now = micros();
+    if (motionSamples_ > 0 && now - lastMotion_ < 100000) {
+      uint32_t dt = now - lastMotion_;
+      period_ = period_ ? (period_ * 7 + dt) / 8 : dt;
+    }
+    lastMotion_ = now;
+    motionSamples_++;
+
+    Stats& s = stats_[CLIENT_MOTION];
+    s.transactions++;
+    s.busy += transferMicros(KYBER_MOTION_READ_BYTES);
+  }
+
+  // Pide el bus para una transferencia del PN532 de 'bytes' bytes. Si se
+  // concede, el cerrojo del bus queda tomado hasta release().
+  // force: sin el margen hasta la siguiente muestra (abortar, despertar); el
+  // cerrojo se respeta siempre.
+  bool acquire(uint8_t bytes, bool force = false) {
+    uint32_t now = micros();
+    if (!force && motionActive(now)) {
+      uint32_t cost = transferMicros(bytes) + KYBER_I2C_GUARD_US;
+      uint32_t since = now - lastMotion_;
+      uint32_t untilNext = since < period_ ? period_ - since : 0;
+      bool fits = untilNext >= cost;
+      bool rightAfterSample = cost > period_ && since < period_ / 4;
+      if (!fits && !rightAfterSample) {
+        stats_[CLIENT_NFC].deferred++;
+        return false;
+      }
+    }
+    if (!I2CLock()) {
+      stats_[CLIENT_NFC].locked++;
+      return false;
+    }
+    start_ = now;
+    return true;
+  }
+
+  // Fin de la transferencia concedida por acquire().
+  void release() {
+    I2CUnlock();
+    uint32_t elapsed = micros() - start_;
+    Stats& s = stats_[CLIENT_NFC];
+    s.transactions++;
+    s.busy += elapsed;
+    if (elapsed > s.max) s.max = elapsed;
+  }
+
+  void print() const {
+    static const char* const names[CLIENT_COUNT] = { "nfc", "motion" };
+    uint32_t window = micros() - windowStart_;
+    for (uint8_t i = 0; i < CLIENT_COUNT; i++) {
+      const Stats& s = stats_[i];
+      STDOUT.print("i2c ");
+      STDOUT.print(names[i]);
+      STDOUT.print(": n=");
+      STDOUT.print(s.transactions);
+      STDOUT.print(" busy=");
+      STDOUT.print(s.busy);
+      STDOUT.print("us (");
+      STDOUT.print(window ? (uint32_t)((uint64_t)s.busy * 1000 / window) : 0);
+      STDOUT.print(" permil)");
+      if (i == CLIENT_NFC) {
+        STDOUT.print(" max=");
+        STDOUT.print(s.max);
+        STDOUT.print("us deferred=");
+        STDOUT.print(s.deferred);
+        STDOUT.print(" locked=");
+        STDOUT.print(s.locked);
+      } else {
+        STDOUT.print(" period=");
+        STDOUT.print(period_);
+        STDOUT.print("us (estimated)");
+      }
+      STDOUT.println("");
+    }
+  }
+
+private:
+  struct Stats {
+    uint32_t transactions;
+    uint32_t busy;
+    uint32_t max;
+    uint32_t deferred;   // Aplazadas por la predicción de la siguiente muestra.
+    uint32_t locked;     // Aplazadas con el cerrojo del bus ocupado.
+  };
+
+  // Sin muestras recientes (IMU parado o sin ENABLE_MOTION) no hay nada que proteger.
+  bool motionActive(uint32_t now) const {
+    return motionSamples_ >= 2 && period_ > 0 && now - lastMotion_ < period_ * 4;
+  }
+
+  Stats stats_[CLIENT_COUNT];
+  uint32_t windowStart_;
+  uint32_t lastMotion_;
+  uint32_t period_;
+  uint32_t motionSamples_;
+  uint32_t start_;
+};
+
+KyberI2CScheduler kyber_i2c;
+
+#endif
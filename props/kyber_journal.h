@@ -0,0 +1,156 @@
+#ifndef PROPS_KYBER_JOURNAL_H
+#define PROPS_KYBER_JOURNAL_H
+
+// =========================================
+// KYBER JOURNAL - Estado del cristal diferido
+// =========================================
+// Mantiene en RAM el último estado del cristal (preset y color) y solo lo
+// escribe en la SD cuando se le pide vaciarse, de forma que varios cambios
+// seguidos de cristal acaban en una sola escritura.
+// En la SD son dos ficheros de solo-añadir con registros de 12 bytes:
+//   'K' 2 secuencia(4, LE) preset(2, LE) R G B CRC-8
+// Los de la versión 1 ('K' 1 secuencia preset R G B flags CRC-8, con el
+// preset en un byte) se siguen leyendo.
+// Al recuperar gana el registro válido de mayor secuencia de los dos; un
+// registro a medio escribir por un corte de alimentación no pasa el CRC y se
+// ignora. Al compactar se reescribe el fichero inactivo con un único registro,
+// así que el activo sigue intacto si se corta la alimentación a mitad.
+
+#ifndef KYBER_JOURNAL_MAX_RECORDS
+#define KYBER_JOURNAL_MAX_RECORDS 64
+#endif
+
+class KyberJournal {
+public:
+  struct State {
+    uint16_t preset;   // Como en la caché de cristales: más de 255 presets.
+    uint8_t color[3];
+  };
+
+  KyberJournal() : pending_(false), sequence_(0), records_(0), active_(0) {}
+
+  // Anota el nuevo estado. Sustituye a cualquier otro pendiente de escribir.
+  void record(uint16_t preset, const uint8_t* color) {
+    state_.preset = preset;
+    memcpy(state_.color, color, sizeof(state_.color));
+    pending_ = true;
+  }
+
+  bool pending() const { return pending_; }
+  const State& state() const { return state_; }
+
+#ifdef ENABLE_SD
+  // Recupera el último estado válido de los dos ficheros del diario.
+  bool recover(const char* first, const char* second, State* out) {
+    const char* files[2] = { first, second };
+    bool found = false;
+    records_ = 0;
+    active_ = 0;
+    for (uint8_t i = 0; i < 2; i++) {
+      uint16_t records = 0;
+      if (recoverFile(files[i], &records, &found, out)) {
+        active_ = i;
+        records_ = records;
+      }
+    }
+    if (found) state_ = *out;
+    return found;
+  }
+
+  // Escribe el estado pendiente. Si el fichero activo ha crecido demasiado se
+  // escribe el registro en el otro, vaciándolo antes, y pasa a ser el activo.
+  bool flush(const char* first, const char* second) {
+    if (!pending_) return true;
+
+    uint8_t record[RECORD_SIZE];
+    uint32_t seq = sequence_ + 1;
+    record[0] = 'K';
+    record[1] = VERSION;
+    record[2] = seq;
+    record[3] = seq >> 8;
+    record[4] = seq >> 16;
+    record[5] = seq >> 24;
+    record[6] = state_.preset;
+    record[7] = state_.preset >> 8;
+    memcpy(record + 8, state_.color, 3);
+    record[11] = crc8(record, RECORD_SIZE - 1);
+
+    const char* files[2] = { first, second };
+    bool compact = records_ >= KYBER_JOURNAL_MAX_RECORDS;
+    uint8_t target = compact ? 1 - active_ : active_;
+    File f = compact ? LSFS::OpenForWrite(files[target]) : LSFS::OpenForAppend(files[target]);
+    if (!f) return false;
+
+    bool ok = f.write(record, sizeof(record)) == sizeof(record);
+    f.close();
+    if (!ok) return false;
+
+    sequence_ = seq;
+    pending_ = false;
+    if (compact) {
+      active_ = target;
+      records_ = 0;
+    }
+    records_++;
+    return true;
+  }
+#endif
+
+private:
+  static constexpr uint8_t VERSION = 2;
+  static constexpr uint8_t RECORD_SIZE = 12;
+
+#ifdef ENABLE_SD
+  // Lee un fichero del diario. Devuelve true si tiene un registro más nuevo
+  // que los encontrados hasta ahora; cuenta sus registros en records.
+  bool recoverFile(const char* filename, uint16_t* records, bool* found, State* out) {
+    if (!LSFS::Exists(filename)) return false;
+    File f = LSFS::Open(filename);
+    if (!f) return false;
+
+    bool newer = false;
+    uint8_t record[RECORD_SIZE];
+    while (f.read(record, sizeof(record)) == sizeof(record)) {
+      (*records)++;
+      if (record[0] != 'K' || (record[1] != 1 && record[1] != VERSION)) continue;
+      if (crc8(record, RECORD_SIZE - 1) != record[RECORD_SIZE - 1]) continue;
+
+      uint32_t seq = record[2] | (record[3] << 8) | ((uint32_t)record[4] << 16) | ((uint32_t)record[5] << 24);
+      if (*found && seq < sequence_) continue;
+
+      sequence_ = seq;
+      if (record[1] == 1) {
+        out->preset = record[6];
+        memcpy(out->color, record + 7, 3);
+      } else {
+        out->preset = record[6] | (record[7] << 8);
+        memcpy(out->color, record + 8, 3);
+      }
+      *found = true;
+      newer = true;
+    }
+    f.close();
+    return newer;
+  }
+#endif
+
+  // CRC-8 (polinomio 0x07).
+  static uint8_t crc8(const uint8_t* data, uint8_t len) {
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < len; i++) {
+      crc ^= data[i];
+      for (uint8_t b = 0; b < 8; b++) {
+        crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+      }
+    }
+    return crc;
+  }
+
+  State state_;
+  bool pending_;
+  uint32_t sequence_;
+  uint16_t records_;   // Registros en el fichero activo, para saber cuándo compactar.
+  uint8_t active_;     // Fichero del diario al que se añade (0 o 1).
+};
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef PROPS_KYBER_LOG_H
+#define PROPS_KYBER_LOG_H
+
+#include <stdarg.h>
+
+// =========================================
+// KYBER LOG - Trazas sin memoria dinámica
+// =========================================
+// Los mensajes se formatean con vsnprintf en una línea en la pila y se copian
+// a un buffer circular fijo. El Loop() del prop lo va volcando al puerto serie
+// a trozos, así que registrar un mensaje no asigna memoria ni espera al serie.
+// Si el buffer se llena, las líneas nuevas se descartan y se cuentan.
+//
+// KYBER_LOG_LEVEL elige qué se compila:
+//   0 = nada, 1 = errores, 2 = eventos (por defecto), 3 = depuración.
+// Los niveles desactivados no generan código ni evalúan sus argumentos.
+
+#define KYBER_LOG_NONE  0
+#define KYBER_LOG_ERROR 1
+#define KYBER_LOG_INFO  2
+#define KYBER_LOG_DEBUG 3
+
+#ifndef KYBER_LOG_LEVEL
+#define KYBER_LOG_LEVEL KYBER_LOG_INFO
+#endif
+
+#ifndef KYBER_LOG_BUFFER
+#define KYBER_LOG_BUFFER 512
+#endif
+
+#if KYBER_LOG_LEVEL > KYBER_LOG_NONE
+
+class KyberLog {
+public:
+  static constexpr size_t MAX_LINE = 96;
+
+  KyberLog() : head_(0), tail_(0), dropped_(0) {}
+
+  __attribute__((format(printf, 2, 3)))
+  void printf(const char* format, ...) {
+    char line[MAX_LINE];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(line, sizeof(line) - 1, format, args);
+    va_end(args);
+    if (len < 0) return;
+    if (len > (int)sizeof(line) - 2) len = sizeof(line) - 2;
+    line[len++] = '\n';
+
+    if ((size_t)len > space()) {
+      dropped_++;
+      return;
+    }
+    for (int i = 0; i < len; i++) {
+      buffer_[head_] = line[i];
+      head_ = (head_ + 1) % KYBER_LOG_BUFFER;
+    }
+  }
+
+  // Vuelca al serie como mucho maxBytes.
+  void drain(size_t maxBytes = 64) {
+    if (dropped_ && space() > 24) {
+      uint32_t dropped = dropped_;
+      dropped_ = 0;
+      printf("! Log overflow, %lu lines lost", (unsigned long)dropped);
+    }
+    while (tail_ != head_ && maxBytes > 0) {
+      // Trozo contiguo hasta el final del buffer o hasta head_.
+      size_t end = head_ > tail_ ? head_ : KYBER_LOG_BUFFER;
+      size_t len = end - tail_;
+      if (len > maxBytes) len = maxBytes;
+      STDOUT.write((const uint8_t*)buffer_ + tail_, len);
+      tail_ = (tail_ + len) % KYBER_LOG_BUFFER;
+      maxBytes -= len;
+    }
+  }
+
+private:
+  size_t space() const {
+    return (tail_ + KYBER_LOG_BUFFER - head_ - 1) % KYBER_LOG_BUFFER;
+  }
+
+  char buffer_[KYBER_LOG_BUFFER];
+  size_t head_;
+  size_t tail_;
+  uint32_t dropped_;
+};
+
+KyberLog kyber_log;
+
+#define KYBER_LOG_DRAIN() kyber_log.drain()
+#else
+#define KYBER_LOG_DRAIN() do {} while (0)
+#endif
+
+#if KYBER_LOG_LEVEL >= KYBER_LOG_ERROR
+#define KYBER_ERROR(...) kyber_log.printf(__VA_ARGS__)
+#else
+#define KYBER_ERROR(...) do {} while (0)
+#endif
+
+#if KYBER_LOG_LEVEL >= KYBER_LOG_INFO
+#define KYBER_INFO(...) kyber_log.printf(__VA_ARGS__)
+#else
+#define KYBER_INFO(...) do {} while (0)
+#endif
+
+#if KYBER_LOG_LEVEL >= KYBER_LOG_DEBUG
+#define KYBER_DEBUG(...) kyber_log.printf(__VA_ARGS__)
+#else
+#define KYBER_DEBUG(...) do {} while (0)
+#endif
+
+#endif
@@ -0,0 +1,371 @@
+#ifndef PROPS_KYBER_METRICS_H
+#define PROPS_KYBER_METRICS_H
+
+// =========================================
+// KYBER METRICS - Medidas del prop en la placa
+// =========================================
+// Cuenta lo que hay que vigilar para no empeorar el prop: el peor Loop(), la
+// latencia desde que se detecta un cristal hasta que se ve su color y las
+// escrituras en la SD, y el tiempo con el PN532 despierto (campo RF
+// encendido) junto con los sondeos enviados, para estimar el consumo. También
+// cuánto tarda la placa en estar lista tras arrancar y cuánto cuesta cada
+// encendido del filo, el primero aparte, y cuántas lecturas de cristal
+// terminan, se reintentan o se abandonan. Cada medida tiene un presupuesto; al superarlo se
+// registra un error y el comando kyber_stats marca la medida como FAIL.
+// Las pasadas que aplican un cristal, escriben en la SD o restauran el preset
+// se miden aparte: su coste se vigila con la latencia del cambio.
+// Además, cada fase del prop se cronometra con el contador de ciclos (DWT
+// en Cortex-M, micros() si no lo hay) y guarda mínimo, media, máximo y un
+// histograma logarítmico en microsegundos. Si una fase se ejecuta dentro de
+// otra (aplicar un cristal al detectarlo), solo cuenta en la interior.
+// Con KYBER_STATS a 0 las clases quedan vacías y no cuestan nada.
+
+#ifndef KYBER_STATS
+#define KYBER_STATS 1
+#endif
+
+// Presupuestos por defecto.
+#ifndef KYBER_LOOP_BUDGET_US
+#define KYBER_LOOP_BUDGET_US 1000
+#endif
+
+#ifndef KYBER_SWAP_BUDGET_MS
+#define KYBER_SWAP_BUDGET_MS 250
+#endif
+
+#if KYBER_STATS
+
+class KyberMetrics {
+public:
+  enum ReadResult : uint8_t {
+    READ_OK,        // Cristal leído entero.
+    READ_RETRIED,   // Lectura retomada tras un READ fallido.
+    READ_ABORTED,   // Lectura abandonada (reintentos agotados, datos inválidos o cristal retirado).
+    READ_RESULTS
+  };
+
+  KyberMetrics() : rfOn_(false), rfOnSince_(0), bootReady_(0), ignitionFirst_(0) { reset(); }
+
+  void reset() {
+    loops_ = 0;
+    loopMax_ = 0;
+    loopOverBudget_ = 0;
+    heavyLoopMax_ = 0;
+    swaps_ = 0;
+    swapLast_ = 0;
+    swapMax_ = 0;
+    swapOverBudget_ = 0;
+    sdWrites_ = 0;
+    polls_ = 0;
+    rfWindows_ = 0;
+    rfOnTotal_ = 0;
+    if (rfOn_) rfOnSince_ = millis();
+    ignitions_ = 0;
+    ignitionLast_ = 0;
+    ignitionMax_ = 0;
+    memset(reads_, 0, sizeof(reads_));
+  }
+
+  // Duración del trabajo del prop en una pasada por Loop().
+  void addLoop(uint32_t us, bool heavy) {
+    if (heavy) {
+      if (us > heavyLoopMax_) heavyLoopMax_ = us;
+      return;
+    }
+    loops_++;
+    if (us > KYBER_LOOP_BUDGET_US) {
+      loopOverBudget_++;
+      if (us > loopMax_) KYBER_ERROR("! Loop over budget: %lu us", (unsigned long)us);
+    }
+    if (us > loopMax_) loopMax_ = us;
+  }
+
+  // Detección del cristal hasta el primer frame con su color.
+  void addSwap(uint32_t ms) {
+    swaps_++;
+    swapLast_ = ms;
+    if (ms > swapMax_) swapMax_ = ms;
+    if (ms > KYBER_SWAP_BUDGET_MS) {
+      swapOverBudget_++;
+      KYBER_ERROR("! Swap over budget: %lu ms", (unsigned long)ms);
+    }
+  }
+
+  void addSDWrite() { sdWrites_++; }
+
+  void addPoll() { polls_++; }
+
+  void addRead(ReadResult result) { reads_[result]++; }
+
+  // Arranque hasta tener el preset restaurado y el PN532 inicializado.
+  // No se borra con reset(): solo ocurre una vez.
+  void setBootReady(uint32_t ms) { bootReady_ = ms; }
+
+  // Trabajo del prop al encender el filo. El primero se guarda aparte.
+  void addIgnition(uint32_t us) {
+    if (ignitionFirst_ == 0) ignitionFirst_ = us;
+    ignitions_++;
+    ignitionLast_ = us;
+    if (us > ignitionMax_) ignitionMax_ = us;
+  }
+
+  // Ventana NFC abierta (PN532 despierto) o cerrada (PowerDown).
+  void rfOn() {
+    if (rfOn_) return;
+    rfOn_ = true;
+    rfOnSince_ = millis();
+    rfWindows_++;
+  }
+
+  void rfOff() {
+    if (!rfOn_) return;
+    rfOn_ = false;
+    rfOnTotal_ += millis() - rfOnSince_;
+  }
+
+  void print() const {
+    STDOUT.print("loop: max=");
+    STDOUT.print(loopMax_);
+    STDOUT.print("us over=");
+    STDOUT.print(loopOverBudget_);
+    STDOUT.print("/");
+    STDOUT.print(loops_);
+    STDOUT.println(loopOverBudget_ ? " FAIL" : " PASS");
+
+    STDOUT.print("loop (apply/sd): max=");
+    STDOUT.print(heavyLoopMax_);
+    STDOUT.println("us");
+
+    STDOUT.print("swap: last=");
+    STDOUT.print(swapLast_);
+    STDOUT.print("ms max=");
+    STDOUT.print(swapMax_);
+    STDOUT.print("ms over=");
+    STDOUT.print(swapOverBudget_);
+    STDOUT.print("/");
+    STDOUT.print(swaps_);
+    STDOUT.println(swapOverBudget_ ? " FAIL" : " PASS");
+
+    STDOUT.print("sd writes: ");
+    STDOUT.println(sdWrites_);
+
+    STDOUT.print("rf on: ");
+    STDOUT.print(rfOnTotal_ + (rfOn_ ? millis() - rfOnSince_ : 0));
+    STDOUT.print("ms windows=");
+    STDOUT.print(rfWindows_);
+    STDOUT.print(" polls=");
+    STDOUT.print(polls_);
+    STDOUT.println(rfOn_ ? " (on)" : " (off)");
+
+    STDOUT.print("reads: ok=");
+    STDOUT.print(reads_[READ_OK]);
+    STDOUT.print(" retried=");
+    STDOUT.print(reads_[READ_RETRIED]);
+    STDOUT.print(" aborted=");
+    STDOUT.println(reads_[READ_ABORTED]);
+
+    STDOUT.print("boot: ready=");
+    STDOUT.print(bootReady_);
+    STDOUT.println("ms");
+
+    STDOUT.print("ignition: first=");
+    STDOUT.print(ignitionFirst_);
+    STDOUT.print("us last=");
+    STDOUT.print(ignitionLast_);
+    STDOUT.print("us max=");
+    STDOUT.print(ignitionMax_);
+    STDOUT.print("us n=");
+    STDOUT.println(ignitions_);
+  }
+
+private:
+  uint32_t loops_;
+  uint32_t loopMax_;
+  uint32_t loopOverBudget_;
+  uint32_t heavyLoopMax_;
+  uint32_t swaps_;
+  uint32_t swapLast_;
+  uint32_t swapMax_;
+  uint32_t swapOverBudget_;
+  uint32_t sdWrites_;
+  uint32_t polls_;
+  uint32_t rfWindows_;
+  uint32_t rfOnTotal_;
+  bool rfOn_;
+  uint32_t rfOnSince_;
+  uint32_t bootReady_;
+  uint32_t ignitionFirst_;
+  uint32_t ignitions_;
+  uint32_t ignitionLast_;
+  uint32_t ignitionMax_;
+  uint32_t reads_[READ_RESULTS];
+};
+
+// Fases del prop que se cronometran por separado.
+enum KyberPhase : uint8_t {
+  KYBER_PHASE_INIT,     // Inicialización del PN532.
+  KYBER_PHASE_TIMEOUT,  // Comprobación del timeout de la ventana NFC.
+  KYBER_PHASE_DETECT,   // Detección del cristal (InListPassiveTarget / InAutoPoll).
+  KYBER_PHASE_READ,     // Lectura de las páginas del cristal.
+  KYBER_PHASE_APPLY,    // Aplicar preset y color.
+  KYBER_PHASE_SD,       // Escrituras en la SD.
+  KYBER_PHASE_LED,      // Render del LED del cristal.
+  KYBER_PHASE_COUNT
+};
+
+class KyberPhaseStats {
+public:
+  static constexpr uint8_t BUCKETS = 12;  // <2us, <4us, ... >=2048us.
+
+  KyberPhaseStats() : counterEnabled_(false) { reset(); }
+
+  void reset() {
+    for (uint8_t i = 0; i < KYBER_PHASE_COUNT; i++) {
+      Phase& p = phases_[i];
+      p.count = 0;
+      p.total = 0;
+      p.min = 0xFFFFFFFF;
+      p.max = 0;
+      memset(p.histogram, 0, sizeof(p.histogram));
+    }
+  }
+
+  uint32_t now() {
+#ifdef DWT
+    if (!counterEnabled_) {
+      CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+      DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+      counterEnabled_ = true;
+    }
+    return DWT->CYCCNT;
+#else
+    return micros();
+#endif
+  }
+
+  void add(KyberPhase phase, uint32_t ticks) {
+    Phase& p = phases_[phase];
+    p.count++;
+    p.total += ticks;
+    if (ticks < p.min) p.min = ticks;
+    if (ticks > p.max) p.max = ticks;
+
+    uint32_t us = toMicros(ticks);
+    uint8_t bucket = us < 2 ? 0 : 31 - __builtin_clz(us);
+    if (bucket >= BUCKETS) bucket = BUCKETS - 1;
+    p.histogram[bucket]++;
+  }
+
+  void print() {
+    static const char* const names[KYBER_PHASE_COUNT] = {
+      "init", "timeout", "detect", "read", "apply", "sd", "led"
+    };
+    STDOUT.println("phase: count min/avg/max us | histogram <2us <4us ... >=2048us");
+    for (uint8_t i = 0; i < KYBER_PHASE_COUNT; i++) {
+      const Phase& p = phases_[i];
+      STDOUT.print(names[i]);
+      STDOUT.print(": ");
+      STDOUT.print(p.count);
+      if (p.count) {
+        STDOUT.print(" ");
+        STDOUT.print(toMicros(p.min));
+        STDOUT.print("/");
+        STDOUT.print(toMicros(p.total / p.count));
+        STDOUT.print("/");
+        STDOUT.print(toMicros(p.max));
+        STDOUT.print(" |");
+        for (uint8_t b = 0; b < BUCKETS; b++) {
+          STDOUT.print(" ");
+          STDOUT.print(p.histogram[b]);
+        }
+      }
+      STDOUT.println("");
+    }
+  }
+
+private:
+  struct Phase {
+    uint32_t count;
+    uint64_t total;
+    uint32_t min;
+    uint32_t max;
+    uint32_t histogram[BUCKETS];
+  };
+
+  static uint32_t toMicros(uint64_t ticks) {
+#ifdef DWT
+    return ticks / (SystemCoreClock / 1000000);
+#else
+    return ticks;
+#endif
+  }
+
+  Phase phases_[KYBER_PHASE_COUNT];
+  bool counterEnabled_;
+};
+
+KyberPhaseStats kyber_phase_stats;
+
+// Cronometra el resto del ámbito en el que se declara. El tiempo de los
+// temporizadores anidados se descuenta del que los contiene.
+class KyberPhaseTimer {
+public:
+  explicit KyberPhaseTimer(KyberPhase phase)
+    : phase_(phase), parent_(active_), nested_(0), start_(kyber_phase_stats.now()) {
+    active_ = this;
+  }
+
+  ~KyberPhaseTimer() {
+    uint32_t elapsed = kyber_phase_stats.now() - start_;
+    kyber_phase_stats.add(phase_, elapsed - nested_);
+    if (parent_) parent_->nested_ += elapsed;
+    active_ = parent_;
+  }
+
+private:
+  static KyberPhaseTimer* active_;
+
+  KyberPhase phase_;
+  KyberPhaseTimer* parent_;
+  uint32_t nested_;
+  uint32_t start_;
+};
+
+KyberPhaseTimer* KyberPhaseTimer::active_ = nullptr;
+
+#define KYBER_PHASE_CAT2(a, b) a##b
+#define KYBER_PHASE_CAT(a, b) KYBER_PHASE_CAT2(a, b)
+#define KYBER_TIME_PHASE(phase) KyberPhaseTimer KYBER_PHASE_CAT(kyberPhaseTimer, __LINE__)(phase)
+
+#else
+
+#define KYBER_TIME_PHASE(phase) do {} while (0)
+
+class KyberMetrics {
+public:
+  enum ReadResult : uint8_t { READ_OK, READ_RETRIED, READ_ABORTED };
+
+  void reset() {}
+  void addLoop(uint32_t us, bool heavy) {}
+  void addSwap(uint32_t ms) {}
+  void addSDWrite() {}
+  void addPoll() {}
+  void addRead(ReadResult result) {}
+  void rfOn() {}
+  void rfOff() {}
+  void setBootReady(uint32_t ms) {}
+  void addIgnition(uint32_t us) {}
+  void print() const { STDOUT.println("Stats disabled (KYBER_STATS 0)"); }
+};
+
+class KyberPhaseStats {
+public:
+  void reset() {}
+  void print() {}
+};
+
+KyberPhaseStats kyber_phase_stats;
+
+#endif
+
+#endif
@@ -1,476 +1,1329 @@
-#ifndef PROPS_KYBER_NFC_H
-#define PROPS_KYBER_NFC_H
-
-#include "prop_base.h"
-#include <Wire.h>
-#include <Adafruit_PN532.h>
-#include "../common/i2cbus.h"
-
-extern I2CBus i2cbus;
-
-// =========================================
-// KYBER NFC PROP - Sistema de cristales NFC
-// =========================================
-class KyberNFC : public PropBase {
-private:
-  static constexpr const char* DEFAULT_PRESET_NAME = "default";
-  Adafruit_PN532* nfc;
-  bool nfcInitialized;
-  bool nfcActive;
-  
-  uint8_t lastUID[7];
-  uint8_t lastUIDLength;
-  uint8_t nfcColor[3];
-  bool tagCurrentlyPresent;
-  char nfcPresetName[32];
-  uint32_t lastCheckTime;
-  uint32_t nfcActiveStartTime; 
-  bool crystalLEDOn = false;       // Indica si el cristal está encendido.
-  uint32_t crystalLEDOnTime = 0;   // Momento en que se encendió el cristal.
-  bool needsPresetReload = true;   // La primera vez que arranca necesita cargar el preset de la SD.
-  
-  // IDs de los diferentes Blades que componen el sistema.
-  static constexpr int MAIN_BLADE = 1;
-  static constexpr int CRYSTAL_CHAMBER = 2;
-
-  // Estilo personalizado para el LED del cristal.
-  class CrystalLEDStyle : public BladeStyle {
-  public:
-    CrystalLEDStyle(uint16_t r, uint16_t g, uint16_t b, uint32_t durationMs)
-      : r_(r), g_(g), b_(b), duration_(durationMs), startTime_(millis()) {}
-
-    bool isFinished() const {
-      if (duration_ == 0) return false; // Permanente nunca termina.
-      return (millis() - startTime_) >= duration_; // Termina al finalizar la duración.
-    }
-
-    bool isTemporaryActive() const {
-        // Indica si ha terminado la animación de feedback del cristal cuando esta no es ilimitada.
-        return duration_ > 0 && (millis() - startTime_) < duration_;
-    }
-
-    void run(BladeBase* blade) override {
-      uint32_t elapsed = millis() - startTime_;
-
-      // Encendido permanente (duration = 0).
-      if (duration_ == 0) {
-        runPulsing(blade);
-        return;
-      }
-
-      // Encendido temporal.
-      if (elapsed < duration_ - 1000) {
-        runPulsing(blade);
-        return;
-      }
-
-      // Fade out.
-      if (elapsed < duration_) {
-        uint32_t fadeProgress = elapsed - (duration_ - 1000);
-        uint16_t brightness = 65535 - ((fadeProgress * 65535) / 1000);
-
-        uint16_t r = (r_ * brightness) >> 16;
-        uint16_t g = (g_ * brightness) >> 16;
-        uint16_t b = (b_ * brightness) >> 16;
-
-        blade->set(0, Color16(r, g, b));
-        return;
-      }
-
-      // Apagado - todos los LEDs del cristal en negro.
-      for (int i = 0; i < blade->num_leds(); i++) {
-        blade->set(i, Color16(0, 0, 0));
-      }
-    }
-
-    // IMPORTANTE: Solo mantener con energía mientras está activo.
-    // Si se deja con energía siempre, produce sobrecalentamiento y consume más batería.
-    bool NoOnOff() override { 
-      if (duration_ == 0) {
-        return true; // Permanente, con energía mientras dure el estilo.
-      }
-      
-      uint32_t elapsed = millis() - startTime_;
-      return elapsed < duration_; // Al finalizar la duración, permite desconectar el cristal de la batería.
-    }
-    
-    bool IsHandled(HandledFeature feature) override { return false; }
-
-  private:
-    void runPulsing(BladeBase* blade) {
-      uint32_t phase = (millis() * 65536) / 1500;
-      uint16_t brightness = (sin_table[(phase >> 8) & 0xFF] + 32768);
-
-      uint16_t r = (r_ * brightness) >> 16;
-      uint16_t g = (g_ * brightness) >> 16;
-      uint16_t b = (b_ * brightness) >> 16;
-
-      blade->set(0, Color16(r, g, b));
-    }
-
-    uint16_t r_, g_, b_;
-    uint32_t duration_;
-    uint32_t startTime_;
-  };
-  
-  CrystalLEDStyle* crystalStyle_;
-  BladeStyle* savedCrystalStyle_;
-  
-public:
-  KyberNFC() : PropBase(), lastUIDLength(0), lastCheckTime(0), 
-               nfcInitialized(false), nfcActive(false), tagCurrentlyPresent(false),
-               nfcActiveStartTime(0), crystalStyle_(nullptr), savedCrystalStyle_(nullptr) {
-    nfc = new Adafruit_PN532(255, 255);
-    nfcColor[0] = 255;
-    nfcColor[1] = 255;
-    nfcColor[2] = 255;
-    strcpy(nfcPresetName, DEFAULT_PRESET_NAME);
-  }
-  
-  ~KyberNFC() {
-    if(nfc) delete nfc;
-    if(crystalStyle_) delete crystalStyle_;
-  }
-  
-  const char* name() override { return "KyberNFC"; }
-  
-  void Loop() override {
-    PropBase::Loop();
-    
-    if(!nfcInitialized) {
-      initNFC();
-      if(nfcInitialized) {
-        activateNFC();
-      }
-    }
-
-    // Limpiar estilo del cristal cuando termine
-    if (crystalLEDOn && crystalStyle_ && crystalStyle_->isFinished()) {
-      deactivateCrystalLED();
-    }
-
-    // Verificar timeout del NFC
-    if (nfcActive && NFC_TIMEOUT > 0) {
-      uint32_t elapsed = (millis() - nfcActiveStartTime) / 1000;  // Convertir a segundos
-      if (elapsed >= NFC_TIMEOUT) {
-        STDOUT.println(String("-- NFC timeout reached (") + NFC_TIMEOUT + "s), putting NFC to sleep");
-        deactivateNFC();
-      }
-    }
-
-    if(!SaberBase::IsOn() && nfcInitialized && nfcActive) {
-      processNFC();
-    }
-  }
-  
-  bool Event2(enum BUTTON button, EVENT event, uint32_t modifiers) override {
-    switch (EVENTID(button, event, modifiers)) {
-      case EVENTID(BUTTON_POWER, EVENT_CLICK_SHORT, MODE_OFF):
-        On();
-
-        if (needsPresetReload) {
-          needsPresetReload = false;
-          
-          #ifdef ENABLE_SD
-          if (LSFS::Exists("cur_kyber.txt")) {
-            File f = LSFS::Open("cur_kyber.txt");
-            if (f) {
-              uint8_t buffer[16];
-              size_t bytesRead = f.read(buffer, sizeof(buffer) - 1);
-              buffer[bytesRead] = '\0';
-              f.close();
-              
-              int savedPreset = atoi((char*)buffer);
-              STDOUT.println(String("-- Loading saved preset: ") + savedPreset);
-              SetPreset(savedPreset, true);
-              STDOUT.println("-- Preset reloaded");
-            }
-          }
-          #endif
-        }
-
-        #ifdef CRYSTAL_EDGE_ACTIVATION
-        activateCrystalLED(0);
-        #endif
-
-        return true;
-        
-      case EVENTID(BUTTON_POWER, EVENT_HELD_MEDIUM, MODE_ON):
-        // Que no se apague si el cristal está mostrando un feedback de activación temporal.
-        if (crystalStyle_ && crystalStyle_->isTemporaryActive()) {
-            STDOUT.println("-- Saber off ignored (crystal feedback still active)");
-            return true;  // Ignoramos el OFF
-        }
-
-        Off();
-
-        // Reactivar el timeout del NFC al apagar el filo
-        if (nfcInitialized && !nfcActive) {
-          activateNFC();
-        } else if (nfcInitialized && nfcActive) {
-          // Resetear el timeout si ya está activo
-          nfcActiveStartTime = millis();
-          STDOUT.println("-- NFC timeout reset");
-        }
-
-        #ifdef CRYSTAL_EDGE_ACTIVATION
-        deactivateCrystalLED();
-        #endif
-
-        return true;
-        
-      default:
-        return false;
-    }
-  }
-  
-private:
-  void initNFC() {
-    STDOUT.println("Initializing NFC...");
-    nfc->begin();
-    
-    uint32_t versiondata = nfc->getFirmwareVersion();
-    if (!versiondata) {
-      STDOUT.println("-- NFC Module not found");
-      nfcInitialized = false;
-      return;
-    }
-    
-    STDOUT.print("Found PN532 modul.");
-    STDOUT.println((versiondata >> 24) & 0xFF, HEX);
-    
-    nfc->SAMConfig();
-    nfcInitialized = true;
-  }
-
-  // Activar el NFC
-  void activateNFC() {
-    if (!nfcActive) {
-      STDOUT.println("-- Activating NFC");
-      nfc->SAMConfig();  // Despertar el módulo NFC
-      i2cbus.inited();   // Asegurar que I2C está activo
-      nfcActive = true;
-      nfcActiveStartTime = millis();
-      
-      if (NFC_TIMEOUT > 0) {
-        STDOUT.println(String("-- NFC will sleep after ") + NFC_TIMEOUT + " seconds");
-      } else {
-        STDOUT.println("-- NFC timeout disabled (unlimited)");
-      }
-    }
-  }
-
-  // Desactivar el NFC (modo sleep)
-  void deactivateNFC() {
-    if (nfcActive) {
-      STDOUT.println("-- Deactivating NFC (sleep mode)");
-      
-      nfcActive = false;
-      tagCurrentlyPresent = false;
-    }
-  }
-  
-  void processNFC() {
-    uint32_t now = millis();
-    if(now - lastCheckTime < 500) {
-      return;
-    }
-    lastCheckTime = now;
-
-    i2cbus.inited();
-    
-    uint8_t uid[7];
-    uint8_t uidLength;
-    
-    bool tagPresent = nfc->readPassiveTargetID(PN532_MIFARE_ISO14443A, uid, &uidLength, 50);
-    
-    if(tagPresent) {
-      bool isDifferentTag = isNewTag(uid, uidLength);
-      
-      if(isDifferentTag) {
-        STDOUT.println("-- New Crystal Detected");
-        
-        memcpy(lastUID, uid, uidLength);
-        lastUIDLength = uidLength;
-        tagCurrentlyPresent = true;
-        
-        if(readNFCData()) {
-          applyNFCSettings();
-          activateCrystalLED(6000);
-        }
-      }
-      
-    } else {
-      if(tagCurrentlyPresent) {
-        STDOUT.println("-- Crystal Removed");
-        tagCurrentlyPresent = false;
-      }
-    }
-  }
-  
-  void activateCrystalLED(int durationMs) {
-    uint32_t r16 = (uint32_t)nfcColor[0] * 257;
-    uint32_t g16 = (uint32_t)nfcColor[1] * 257;
-    uint32_t b16 = (uint32_t)nfcColor[2] * 257;
-    
-    STDOUT.println("-- Activating crystal LED");
-    
-    if (current_config && current_config->blade2) {
-
-      // Guardamos el estilo viejo del cristal.
-      if (!savedCrystalStyle_) {
-        savedCrystalStyle_ = current_config->blade2->UnSetStyle();
-      }
-      
-      // Creamos y aplicamos el estilo encendido pulsante.
-      if (crystalStyle_) {
-        delete crystalStyle_;
-        crystalStyle_ = nullptr;
-      }
-      crystalStyle_ = new CrystalLEDStyle(r16, g16, b16, durationMs);
-      current_config->blade2->SetStyle(crystalStyle_);
-      
-      crystalLEDOn = true;
-      crystalLEDOnTime = millis();
-      
-      STDOUT.println("-- Crystal LED active");
-    }
-  }
-
-  void deactivateCrystalLED() {
-    if (crystalStyle_ && current_config && current_config->blade2) {
-      STDOUT.println("-- Deactivating crystal LED");
-      
-      // Quitarmos el estilo personalizado.
-      current_config->blade2->UnSetStyle();
-      
-      // Restauramos el estilo original salvado.
-      if (savedCrystalStyle_) {
-        current_config->blade2->SetStyle(savedCrystalStyle_);
-        savedCrystalStyle_ = nullptr;
-      }
-      
-      delete crystalStyle_;
-      crystalStyle_ = nullptr;
-      crystalLEDOn = false;
-      
-      STDOUT.println("-- Crystal LED off");
-    }
-  }
-  
-  bool isNewTag(uint8_t* uid, uint8_t uidLength) {
-    if(uidLength != lastUIDLength) {
-      return true;
-    }
-    
-    for(uint8_t i = 0; i < uidLength; i++) {
-      if(uid[i] != lastUID[i]) {
-        return true;
-      }
-    }
-    
-    return false;
-  }
-  
-  bool readNFCData() {
-    uint8_t pageBuffer[4];
-    uint8_t decodedData[12];
-
-    const uint8_t firma[12] = { 0x41, 0x72, 0x6B, 0x61, 0x69, 0x76, 0x6F, 0x73,
-                             0x4B, 0x79, 0x62, 0x72 };
-
-    for(uint8_t page = 4; page <= 6; page++) {
-        bool success = nfc->ntag2xx_ReadPage(page, pageBuffer);
-        if(!success) {
-            STDOUT.print("! Error reading crystal ");
-            STDOUT.println(page);
-            strcpy(nfcPresetName, DEFAULT_PRESET_NAME);
-            return false;
-        }
-
-        for(uint8_t i = 0; i < 4; i++) {
-            decodedData[(page-4)*4 + i] = pageBuffer[i] ^ firma[(page-4)*4 + i];
-        }
-    }
-
-    nfcColor[0] = decodedData[0];
-    nfcColor[1] = decodedData[1];
-    nfcColor[2] = decodedData[2];
-    uint8_t presetNameLength = decodedData[3];
-    if (presetNameLength > 8) presetNameLength = 8;
-
-    if (presetNameLength != 0) {
-        memcpy(nfcPresetName, decodedData + 4, presetNameLength);
-        nfcPresetName[presetNameLength] = '\0';
-    } else {
-        strcpy(nfcPresetName, DEFAULT_PRESET_NAME);
-    }
-
-    for (uint8_t i = 0; i < presetNameLength; i++) {
-        if (nfcPresetName[i] < 32 || nfcPresetName[i] > 126) {
-            STDOUT.println("! Invalid preset name characters");
-            strcpy(nfcPresetName, DEFAULT_PRESET_NAME);
-            break;
-        }
-    }
-
-    return true;
-  }
-
-  int findPresetByName(const char* presetName) {
-    for (size_t i = 0; i < current_config->num_presets; i++) {
-      if (strcmp(current_config->presets[i].name, presetName) == 0) {
-        STDOUT.println(String("-- Found preset '") + presetName + "' at index " + i);
-        return i;
-      }
-    }
-    
-    STDOUT.print("! Preset '");
-    STDOUT.print(presetName);
-    STDOUT.println("' not found, using default (0)");
-    return 0;
-  }
-  
-  void applyNFCSettings() {
-    int targetPreset = findPresetByName(nfcPresetName);
-
-    uint32_t r16 = (uint32_t)nfcColor[0] * 257;
-    uint32_t g16 = (uint32_t)nfcColor[1] * 257;
-    uint32_t b16 = (uint32_t)nfcColor[2] * 257;
-
-    STDOUT.println(String("-- Applying color: RGB(") + nfcColor[0] + "," + nfcColor[1] + "," + nfcColor[2] + ")");
-    STDOUT.println(String("-- Target preset: ") + targetPreset + " (" + nfcPresetName + ")");
-
-    SetPreset(targetPreset, false);
-    
-    char styleString[128];
-    snprintf(styleString, sizeof(styleString), "builtin %d 1 %lu,%lu,%lu", 
-             targetPreset, r16, g16, b16);
-    
-    STDOUT.println(String("-- Style: ") + styleString);
-    
-    current_preset_.SetStyle(MAIN_BLADE, LSPtr<char>(mkstr(styleString)));
-    
-    STDOUT.println("-- Saving to presets.ini...");
-    current_preset_.Save();
-    
-    #ifdef ENABLE_SD
-    File f = LSFS::OpenForWrite("cur_kyber.txt");
-    if (f) {
-      uint8_t buffer[16];
-      int len = snprintf((char*)buffer, sizeof(buffer), "%d", targetPreset);
-      f.write(buffer, len);
-      f.close();
-      STDOUT.println(String("-- Saved current preset: ") + targetPreset);
-    }
-    #endif
-    
-    delay(200);
-    
-    SetPreset(targetPreset, true);
-
-    STDOUT.println(String("-- Crystal Bonded (") + nfcColor[0] + "," + nfcColor[1] + "," + nfcColor[2] + ")  Preset: " + nfcPresetName);
-  }
-};
-
+#ifndef PROPS_KYBER_NFC_H
+#define PROPS_KYBER_NFC_H
+
+#include "prop_base.h"
+#include <Wire.h>
+#include "../common/i2cbus.h"
+#include "kyber_log.h"
+#include "kyber_i2c.h"
+#include "kyber_pn532.h"
+#include "kyber_tag.h"
+#include "kyber_cache.h"
+#include "kyber_journal.h"
+#include "kyber_presets.h"
+#include "kyber_metrics.h"
+#include "kyber_crystal_style.h"
+#include "kyber_style_args.h"
+#include "kyber_recorder.h"
+
+extern I2CBus i2cbus;
+
+// Pin IRQ del PN532. Si está definido, la detección usa InAutoPoll y el módulo
+// avisa por IRQ cuando hay un cristal; si no, se sondea cada NFC_POLL_INTERVAL ms.
+#ifdef NFC_IRQ_PIN
+#define KYBER_NFC_IRQ NFC_IRQ_PIN
+#else
+#define KYBER_NFC_IRQ KyberPN532::NO_IRQ
+#endif
+
+// Tiempo sin cambios de cristal tras el que se escribe el estado en la SD.
+#ifndef KYBER_FLUSH_DELAY
+#define KYBER_FLUSH_DELAY 3000
+#endif
+
+// Intervalo de sondeo adaptativo: justo tras apagar el filo o retirar un
+// cristal se sondea cada NFC_POLL_MIN ms y, mientras la cámara siga igual, el
+// intervalo se duplica hasta NFC_POLL_MAX. NFC_POLL_INTERVAL fija un
+// intervalo constante como antes.
+#ifdef NFC_POLL_INTERVAL
+#ifndef NFC_POLL_MIN
+#define NFC_POLL_MIN NFC_POLL_INTERVAL
+#endif
+#ifndef NFC_POLL_MAX
+#define NFC_POLL_MAX NFC_POLL_INTERVAL
+#endif
+#endif
+
+#ifndef NFC_POLL_MIN
+#define NFC_POLL_MIN 100
+#endif
+
+#ifndef NFC_POLL_MAX
+#define NFC_POLL_MAX 2000
+#endif
+
+// Con el filo encendido se siguen leyendo cristales: el color cambia en
+// caliente en los estilos que usan KyberRgbArg<1,...> y el preset se aplica
+// entero (y se guarda) al apagar el filo. A 0, sin lecturas con el filo encendido.
+#ifndef KYBER_LIVE_SWAP
+#define KYBER_LIVE_SWAP 1
+#endif
+
+// Duración del fundido al color nuevo con el filo encendido.
+#ifndef KYBER_LIVE_FADE_MS
+#define KYBER_LIVE_FADE_MS 400
+#endif
+
+// Reintentos de una lectura fallida, cada uno desde la página que falló.
+// Agotados, el cristal no se vuelve a leer hasta retirarlo.
+#ifndef KYBER_READ_RETRIES
+#define KYBER_READ_RETRIES 3
+#endif
+
+// Sondeos seguidos sin cristal para darlo por retirado.
+#ifndef KYBER_PRESENCE_MISSES
+#define KYBER_PRESENCE_MISSES 2
+#endif
+
+// Cristales de la cámara que se buscan en cada sondeo (InListPassiveTarget
+// MaxTg, 1 o 2). Con 2, el segundo solo aporta su color: al argumento
+// KYBER_SECOND_CRYSTAL_ARG del filo o, con KYBER_SECOND_CRYSTAL_BLEND, mezclado
+// con el del principal.
+#ifndef KYBER_MAX_CRYSTALS
+#define KYBER_MAX_CRYSTALS 1
+#endif
+static_assert(KYBER_MAX_CRYSTALS >= 1 && KYBER_MAX_CRYSTALS <= 2,
+              "KYBER_MAX_CRYSTALS must be 1 or 2");
+
+#ifndef KYBER_SECOND_CRYSTAL_ARG
+#define KYBER_SECOND_CRYSTAL_ARG 2
+#endif
+
+// Periodo de InAutoPoll en unidades de 150 ms.
+#ifndef NFC_AUTOPOLL_PERIOD
+#define NFC_AUTOPOLL_PERIOD 1
+#endif
+
+// =========================================
+// KYBER NFC PROP - Sistema de cristales NFC
+// =========================================
+class KyberNFC : public PropBase {
+private:
+  static constexpr const char* DEFAULT_PRESET_NAME = "default";
+  // Cada READ de NTAG2xx devuelve 4 páginas (16 bytes). Un cristal v2 sencillo
+  // cabe en una lectura; los v1 necesitan dos (kyber_tag.h).
+  static constexpr uint8_t FIRST_DATA_PAGE = 4;
+  static constexpr uint8_t PAGES_PER_READ = 4;
+  static constexpr const char* CACHE_FILE = "kyber_cache.bin";
+  // El diario alterna entre dos ficheros para compactar sin riesgo (kyber_journal.h).
+  static constexpr const char* JOURNAL_FILE = "kyber.jnl";
+  static constexpr const char* JOURNAL_FILE_ALT = "kyber.jn2";
+  static constexpr const char* RECORDER_FILE = "kyber_rec.bin";
+  KyberPN532 pn532;    // Transceptor no bloqueante: todo el tráfico con el PN532 pasa por aquí.
+  bool nfcInitialized;
+  bool nfcActive;
+  bool nfcNeedsConfig = false;     // Falta el SAMConfig tras inicializar o despertar el PN532.
+  uint8_t initStep = 0;            // Comando de inicialización en curso.
+  
+  uint8_t lastUID[7];              // Último cristal aplicado (leído entero o de la caché).
+  uint8_t lastUIDLength;
+  uint8_t pendingUID[7];           // Cristal en lectura; pasa a lastUID al terminarla.
+  uint8_t pendingUIDLength = 0;
+  uint8_t failedUID[7];            // Cristal que no se ha podido leer; no se reintenta hasta retirarlo.
+  uint8_t failedUIDLength = 0;
+  uint8_t readRetries = 0;
+  bool readResumePending = false;  // Lectura interrumpida: se retoma desde readPage al volver a detectarlo.
+  uint8_t missCount = 0;           // Sondeos seguidos sin el cristal presente.
+
+  // Segundo cristal. Se identifica por el principio del UID: con dos NTAG la
+  // respuesta de InListPassiveTarget no cabe en una lectura I2C y el segundo
+  // UID llega cortado.
+  static constexpr uint8_t SECOND_KEY_LENGTH = 4;
+  uint8_t secondUID[SECOND_KEY_LENGTH];         // Segundo cristal aplicado.
+  uint8_t secondUIDLength = 0;
+  uint8_t secondPendingUID[SECOND_KEY_LENGTH];  // Segundo cristal en lectura.
+  uint8_t secondPendingUIDLength = 0;
+  uint8_t secondFailedUID[SECOND_KEY_LENGTH];   // No se ha podido leer; no se reintenta hasta retirarlo.
+  uint8_t secondFailedUIDLength = 0;
+  uint8_t secondAttempts = 0;
+  uint8_t secondMiss = 0;
+  uint8_t secondColor[3];
+  uint8_t readTarget = 1;          // Tg del cristal que se está leyendo.
+  bool readingSecond = false;
+  KyberTag nfcTag;                 // Datos del último cristal: color, propietario ("attuned to"), flags...
+  bool tagCurrentlyPresent;
+  char nfcPresetName[32];          // Preset resuelto para el cristal.
+  uint32_t lastCheckTime;
+  uint32_t pollInterval = NFC_POLL_MIN;  // Intervalo actual entre sondeos.
+  uint32_t nfcActiveStartTime; 
+  uint32_t nfcWindowStart = 0;     // Apertura de la ventana NFC (el timeout se reinicia al encender).
+  uint32_t lastInitAttempt = (uint32_t)-5000; // Último intento de inicializar el PN532 (el primero es inmediato).
+  uint32_t crystalLEDOnTime = 0;   // Momento en que se encendió el cristal.
+  bool needsPresetReload = true;   // Falta restaurar el preset del último cristal (se hace en el arranque).
+  bool bootReported = false;       // Ya se ha medido el tiempo hasta estar lista.
+  bool needsStateLoad = true;      // La caché de cristales y el diario se cargan de la SD en el primer Loop().
+  bool forceRevalidate = false;    // Ignorar la caché y leer las páginas del siguiente cristal.
+  KyberCrystalCache crystalCache;
+  KyberJournal journal;            // Estado del cristal pendiente de escribir en la SD.
+  KyberPresetIndex presetIndex;    // Búsqueda de presets por nombre o prefijo.
+  bool presetSavePending = false;  // presets.ini pendiente de guardar.
+  bool stateSavePending = false;   // Preset actual (SaveState) pendiente de guardar.
+  bool hasSavedState = false;      // El diario tenía un estado al arrancar.
+  KyberJournal::State savedState;
+  uint32_t lastSwapTime = 0;
+  uint32_t swapStartMicros = 0;    // Detección del cristal, para medir la latencia hasta el primer frame.
+  bool swapPending = false;
+  bool liveApplyPending = false;   // Cristal cambiado con el filo encendido: falta aplicar su preset.
+  int livePreset = 0;
+  KyberMetrics metrics;            // Peor Loop(), latencia de cambio y escrituras en SD (kyber_stats).
+  bool heavyLoop = false;          // Esta pasada aplica un cristal o usa la SD.
+  KyberRecorder recorder;          // Eventos de los cristales en la SD (kyber_rec.bin).
+
+  // Estados de la máquina de lectura NFC. Cada paso por Loop() avanza como mucho una fase.
+  enum NFCState : uint8_t {
+    NFC_IDLE,        // Esperando al siguiente sondeo.
+    NFC_CONFIGURING, // SAMConfig enviado, esperando respuesta.
+    NFC_DETECTING,   // InListPassiveTarget enviado, esperando respuesta.
+    NFC_AUTOPOLLING, // InAutoPoll enviado, el PN532 avisará por IRQ al detectar un cristal.
+    NFC_READING,     // Leyendo las páginas de datos del cristal.
+    NFC_WAKING,      // PN532 despertado, esperando a que arranque el oscilador.
+    NFC_POWERING_DOWN // PowerDown enviado al cerrar la ventana, esperando respuesta.
+  };
+  NFCState nfcState = NFC_IDLE;
+  uint8_t readPage = FIRST_DATA_PAGE;  // Primera página del READ en curso.
+  uint8_t pageData[KyberTag::MAX_BYTES];
+  
+  // IDs de los diferentes Blades que componen el sistema.
+  static constexpr int MAIN_BLADE = 1;
+  static constexpr int CRYSTAL_CHAMBER = 2;
+
+  // Estilo del LED del cristal (kyber_crystal_style.h), montado en blade2
+  // encima del del preset; nullptr si el LED está apagado. Se crea al
+  // encenderlo y se rearma con cada cristal mientras sigue montado. No se
+  // guarda el puntero: ProffieOS también lo destruye si libera los estilos.
+  CrystalLEDStyle* crystalStyle() const { return CrystalLEDStyle::instance(); }
+  
+public:
+  KyberNFC() : PropBase(), pn532(KYBER_NFC_IRQ), nfcInitialized(false), nfcActive(false),
+               lastUIDLength(0), tagCurrentlyPresent(false), lastCheckTime(0),
+               nfcActiveStartTime(0) {
+    memset(&nfcTag, 0, sizeof(nfcTag));
+    nfcTag.color[0] = 255;
+    nfcTag.color[1] = 255;
+    nfcTag.color[2] = 255;
+    strcpy(nfcPresetName, DEFAULT_PRESET_NAME);
+  }
+  
+  const char* name() override { return "KyberNFC"; }
+  
+  void Loop() override {
+    PropBase::Loop();
+#if KYBER_STATS
+    uint32_t loopStart = micros();
+    heavyLoop = false;
+#endif
+
+    // Volcar al serie un trozo de las trazas pendientes.
+    KYBER_LOG_DRAIN();
+
+    // Cargar de la SD la caché de cristales y el diario.
+    if (needsStateLoad) {
+      needsStateLoad = false;
+      recorder.add(KyberRecorder::EVENT_BOOT, 0);
+      #ifdef ENABLE_SD
+      if (crystalCache.load(CACHE_FILE)) {
+        KYBER_INFO("-- Crystal cache loaded: %u crystals", crystalCache.size());
+      }
+      // Recuperar el diario también fija la secuencia de los registros nuevos.
+      hasSavedState = journal.recover(JOURNAL_FILE, JOURNAL_FILE_ALT, &savedState);
+      #endif
+    }
+
+    // Restaurar el preset del último cristal ya en el arranque, con el filo
+    // apagado, para que el primer encendido no tenga que leer la SD.
+    if (needsPresetReload && !SaberBase::IsOn()) {
+      heavyLoop = true;
+      restoreSavedPreset();
+    }
+    
+    // Inicialización del PN532, un comando por pasada. Sin módulo se reintenta cada 5 s.
+    if(!nfcInitialized) {
+      KYBER_TIME_PHASE(KYBER_PHASE_INIT);
+      processInit();
+    }
+
+    // Lista cuando el primer intento de inicializar el PN532 ha terminado, con o sin módulo.
+    if (!bootReported && (nfcInitialized || (lastInitAttempt != (uint32_t)-5000 && !pn532.busy()))) {
+      bootReported = true;
+      KYBER_INFO("-- Ready %lu ms after boot", (unsigned long)millis());
+      metrics.setBootReady(millis());
+    }
+
+    // Latencia desde la detección del cristal hasta el primer frame con el color nuevo.
+    // Un frame anterior a la detección es todavía del cristal que se ha quitado.
+    CrystalLEDStyle* crystal = crystalStyle();
+    if (swapPending && crystal && crystal->hasRendered() &&
+        (int32_t)(crystal->firstFrameMicros() - swapStartMicros) >= 0) {
+      swapPending = false;
+      uint32_t swapUs = crystal->firstFrameMicros() - swapStartMicros;
+      uint32_t swapMs = swapUs / 1000;
+      KYBER_INFO("-- Swap to first frame: %lu ms", (unsigned long)swapMs);
+      metrics.addSwap(swapMs);
+      recorder.add(KyberRecorder::EVENT_SWAP, 0, lastUID, lastUIDLength, swapUs);
+    }
+
+    // Limpiar estilo del cristal cuando termine
+    if (crystal && crystal->isFinished()) {
+      deactivateCrystalLED();
+    }
+
+    // El cristal cambiado con el filo encendido se aplica entero cuando lleva
+    // un rato apagado, con la retracción ya terminada.
+    if (liveApplyPending && !SaberBase::IsOn() && millis() - lastSwapTime >= KYBER_FLUSH_DELAY) {
+      applyNFCSettings(livePreset);
+    }
+
+    // Escribir el estado del cristal cuando lleve un rato sin cambios.
+    if (!SaberBase::IsOn() && millis() - lastSwapTime >= KYBER_FLUSH_DELAY) {
+      flushCrystalState();
+    }
+
+    if (!SaberBase::IsOn() && recorder.due(millis())) {
+      // Registro de eventos: un lote por pasada y nunca con el filo encendido.
+      KYBER_TIME_PHASE(KYBER_PHASE_SD);
+      heavyLoop = true;
+      recorder.step(RECORDER_FILE);
+    }
+
+    // Verificar timeout del NFC
+    if (nfcActive && NFC_TIMEOUT > 0) {
+      KYBER_TIME_PHASE(KYBER_PHASE_TIMEOUT);
+      uint32_t elapsed = (millis() - nfcActiveStartTime) / 1000;  // Convertir a segundos
+      if (elapsed >= NFC_TIMEOUT) {
+        KYBER_INFO("-- NFC timeout reached (%ds), putting NFC to sleep", NFC_TIMEOUT);
+        deactivateNFC();
+      }
+    }
+
+    // El PowerDown de la ventana que se acaba de cerrar termina aunque el NFC ya no esté activo.
+    if (nfcInitialized && (nfcState == NFC_POWERING_DOWN ||
+                           ((KYBER_LIVE_SWAP || !SaberBase::IsOn()) && nfcActive))) {
+      processNFC();
+    }
+
+#if KYBER_STATS
+    metrics.addLoop(micros() - loopStart, heavyLoop);
+#endif
+  }
+  
+  bool Event2(enum BUTTON button, EVENT event, uint32_t modifiers) override {
+    switch (EVENTID(button, event, modifiers)) {
+      case EVENTID(BUTTON_POWER, EVENT_CLICK_SHORT, MODE_OFF): {
+        uint32_t ignitionStart = micros();
+        // No dejar un comando a medias en el PN532 mientras el filo está encendido.
+        resetNFCState();
+        // Un cambio en caliente que no llegó a aplicarse, antes de encender.
+        // Lo pendiente de escribir en la SD espera a que el filo vuelva a estar
+        // apagado: el encendido no la toca.
+        if (liveApplyPending) applyNFCSettings(livePreset);
+        // Normalmente ya se hizo en el arranque.
+        if (needsPresetReload) restoreSavedPreset();
+        On();
+        metrics.addIgnition(micros() - ignitionStart);
+
+        #if KYBER_LIVE_SWAP
+        // La ventana NFC cuenta de nuevo desde el encendido.
+        if (nfcActive) {
+          nfcActiveStartTime = millis();
+          pollFast();
+        }
+        #endif
+
+        #ifdef CRYSTAL_EDGE_ACTIVATION
+        activateCrystalLED(0);
+        #endif
+
+        return true;
+      }
+        
+      case EVENTID(BUTTON_POWER, EVENT_HELD_MEDIUM, MODE_ON):
+        // Que no se apague si el cristal está mostrando un feedback de activación temporal.
+        if (crystalStyle() && crystalStyle()->isTemporaryActive()) {
+            KYBER_INFO("-- Saber off ignored (crystal feedback still active)");
+            return true;  // Ignoramos el OFF
+        }
+
+        Off();
+
+        // El preset del cristal cambiado en caliente y lo pendiente de escribir
+        // esperan a que acabe la retracción.
+        if (liveApplyPending || statePending()) lastSwapTime = millis();
+
+        // Reactivar el timeout del NFC al apagar el filo
+        if (nfcInitialized && !nfcActive) {
+          activateNFC();
+        } else if (nfcInitialized && nfcActive) {
+          // Resetear el timeout si ya está activo
+          nfcActiveStartTime = millis();
+          resetNFCState();
+          pollFast();
+          KYBER_DEBUG("-- NFC timeout reset");
+        }
+
+        #ifdef CRYSTAL_EDGE_ACTIVATION
+        deactivateCrystalLED();
+        #endif
+
+        return true;
+        
+      default:
+        return false;
+    }
+  }
+
+  // Carga el preset del último cristal: el del diario o, si no hay, el del
+  // formato anterior (cur_kyber.txt). Si ProffieOS ya ha arrancado con ese
+  // preset no se vuelve a cargar.
+  void restoreSavedPreset() {
+    needsPresetReload = false;
+
+    #ifdef ENABLE_SD
+    int savedPreset = -1;
+    if (hasSavedState) {
+      savedPreset = savedState.preset;
+    } else if (LSFS::Exists("cur_kyber.txt")) {
+      File f = LSFS::Open("cur_kyber.txt");
+      if (f) {
+        uint8_t buffer[16];
+        size_t bytesRead = f.read(buffer, sizeof(buffer) - 1);
+        buffer[bytesRead] = '\0';
+        f.close();
+        savedPreset = atoi((char*)buffer);
+      }
+    }
+    if (savedPreset < 0) return;
+
+    if (savedPreset == current_preset_.preset_num) {
+      KYBER_DEBUG("-- Saved preset %d already active", savedPreset);
+      return;
+    }
+    KYBER_INFO("-- Loading saved preset: %d", savedPreset);
+    SetPreset(savedPreset, false);
+    KYBER_INFO("-- Preset reloaded");
+    #endif
+  }
+
+#ifdef ENABLE_MOTION
+  // Las muestras del acelerómetro marcan el ritmo del IMU para repartir el bus I2C.
+  void SB_Accel(const Vec3& accel, bool clear) override {
+    kyber_i2c.motionSample();
+    PropBase::SB_Accel(accel, clear);
+  }
+#endif
+
+  // Cualquier cambio de preset libera los estilos de todos los blades. El del
+  // cristal se desmonta antes, para que se libere solo el estilo del preset
+  // que tapaba, y se vuelve a montar encima del nuevo sin cortar el efecto.
+  void SetPreset(int preset_num, bool announce) override {
+    CrystalLEDStyle* crystal = crystalStyle();
+    kyber_style_args.clear();
+    liveApplyPending = false;
+    if (crystal) crystal->uncover(current_config->blade2);
+    PropBase::SetPreset(preset_num, announce);
+    if (crystal) crystal->cover(current_config->blade2);
+  }
+
+  bool Parse(const char* cmd, const char* arg) override {
+    // Obliga a leer de nuevo el cristal insertado aunque esté en la caché.
+    if (!strcmp(cmd, "kyber_revalidate")) {
+      forceRevalidate = true;
+      lastUIDLength = 0;
+      failedUIDLength = 0;
+      presetIndex.forgetMisses();
+      STDOUT.println("-- Next crystal will be re-read");
+      return true;
+    }
+    if (!strcmp(cmd, "kyber_cache_clear")) {
+      crystalCache.clear();
+      #ifdef ENABLE_SD
+      crystalCache.save(CACHE_FILE);
+      metrics.addSDWrite();
+      #endif
+      STDOUT.println("-- Crystal cache cleared");
+      return true;
+    }
+    // Medidas del prop: peor Loop(), latencia de cambio y escrituras en SD.
+    if (!strcmp(cmd, "kyber_stats")) {
+      if (arg && !strcmp(arg, "reset")) {
+        metrics.reset();
+        kyber_phase_stats.reset();
+        kyber_i2c.reset();
+        STDOUT.println("-- Stats reset");
+      } else {
+        metrics.print();
+        recorder.print();
+        kyber_i2c.print();
+        kyber_phase_stats.print();
+      }
+      return true;
+    }
+    return PropBase::Parse(cmd, arg);
+  }
+  
+private:
+  // Inicializa el PN532 sin bloquear: GetFirmwareVersion y después la
+  // configuración de reintentos. El SAMConfig lo hace activateNFC().
+  void processInit() {
+    if (!pn532.busy()) {
+      // Nada de Wire hasta que ProffieOS haya arrancado el bus.
+      if (millis() - lastInitAttempt < 5000 || !i2cbus.inited()) return;
+      lastInitAttempt = millis();
+      KYBER_INFO("Initializing NFC...");
+      pn532.begin();
+      initStep = 0;
+      sendInitCommand();
+      return;
+    }
+
+    KyberPN532::Result result = pn532.poll();
+    if (result == KyberPN532::PN532_PENDING) return;
+    if (result != KyberPN532::PN532_READY) {
+      KYBER_ERROR(initStep == 0 ? "-- NFC Module not found" : "! NFC init failed");
+      return;
+    }
+
+    if (initStep == 0) {
+      KYBER_INFO("Found PN532 modul.%X", pn532.response()[0]);
+    }
+    if (++initStep < INIT_STEPS) {
+      sendInitCommand();
+      return;
+    }
+
+    nfcInitialized = true;
+    activateNFC();
+  }
+
+  static constexpr uint8_t INIT_STEPS = 2;
+
+  void sendInitCommand() {
+    bool sent;
+    if (initStep == 0) {
+      const uint8_t cmd[] = { KyberPN532::CMD_GET_FIRMWARE_VERSION };
+      sent = pn532.send(cmd, sizeof(cmd), 4, 100);
+    } else {
+      // MaxRetries: sin tag, que InListPassiveTarget responda enseguida en vez de reintentar indefinidamente.
+      const uint8_t cmd[] = { KyberPN532::CMD_RF_CONFIGURATION, 0x05, 0xFF, 0x01, 0x01 };
+      sent = pn532.send(cmd, sizeof(cmd), 0, 100);
+    }
+    if (!sent) {
+      KYBER_ERROR(initStep == 0 ? "-- NFC Module not found" : "! NFC init failed");
+    }
+  }
+
+  // Activar el NFC
+  void activateNFC() {
+    if (!nfcActive) {
+      KYBER_INFO("-- Activating NFC");
+      // El PN532 se despierta (si la ventana anterior lo dejó dormido) en el
+      // primer sondeo, con el bus ya disponible.
+      nfcNeedsConfig = true;
+      nfcActive = true;
+      nfcActiveStartTime = millis();
+      nfcWindowStart = nfcActiveStartTime;
+      resetNFCState();
+      pollFast();
+      metrics.rfOn();
+      recorder.add(KyberRecorder::EVENT_WINDOW_OPEN, 0);
+      
+      if (NFC_TIMEOUT > 0) {
+        KYBER_INFO("-- NFC will sleep after %d seconds", NFC_TIMEOUT);
+      } else {
+        KYBER_INFO("-- NFC timeout disabled (unlimited)");
+      }
+    }
+  }
+
+  // Desactivar el NFC (modo sleep)
+  void deactivateNFC() {
+    if (nfcActive) {
+      KYBER_INFO("-- Deactivating NFC (sleep mode)");
+      
+      nfcActive = false;
+      tagCurrentlyPresent = false;
+      resetNFCState();
+
+      // Apagar campo RF y oscilador hasta el siguiente apagado del filo. La
+      // respuesta del PowerDown se recoge en processNFC().
+      if (pn532.startPowerDown()) {
+        nfcState = NFC_POWERING_DOWN;
+      } else {
+        powerDownFailed();
+      }
+      metrics.rfOff();
+      recorder.add(KyberRecorder::EVENT_TIMEOUT, KyberRecorder::TIMEOUT_SLEEP, nullptr, 0,
+                   KyberRecorder::fromMs(millis() - nfcWindowStart));
+
+      // La placa se va a quedar en reposo: no dejar nada pendiente en RAM. Con
+      // el filo encendido la SD es del audio; lo pendiente se escribe al apagarlo.
+      if (!SaberBase::IsOn()) flushCrystalState();
+    }
+  }
+
+  // El PN532 sigue despierto (campo RF y oscilador) hasta la siguiente ventana.
+  void powerDownFailed() {
+    KYBER_ERROR("! PN532 power down failed");
+    recorder.add(KyberRecorder::EVENT_TIMEOUT, KyberRecorder::TIMEOUT_SLEEP_FAILED);
+  }
+
+  // Cancela cualquier comando en curso y vuelve a esperar al siguiente sondeo.
+  void resetNFCState() {
+    // Un PowerDown en curso se deja terminar: abortarlo dejaría el campo RF encendido.
+    if (nfcState == NFC_POWERING_DOWN) return;
+    pn532.abort();
+    nfcState = NFC_IDLE;
+    readingSecond = false;
+  }
+
+  // Algo ha cambiado en la cámara (o se acaba de apagar el filo): sondear rápido.
+  void pollFast() {
+    pollInterval = NFC_POLL_MIN;
+  }
+
+  // La cámara sigue igual: espaciar los sondeos.
+  void pollBackoff() {
+    pollInterval = pollInterval * 2 < NFC_POLL_MAX ? pollInterval * 2 : NFC_POLL_MAX;
+  }
+  
+  // Máquina de estados de lectura. Envía el comando y vuelve; las respuestas
+  // se recogen en siguientes pasadas por Loop() cuando el PN532 indica que están listas.
+  void processNFC() {
+    switch (nfcState) {
+      case NFC_IDLE: {
+        uint32_t now = millis();
+        if(now - lastCheckTime < pollInterval) {
+          return;
+        }
+        lastCheckTime = now;
+
+        // Mantiene el bus encendido; si ProffieOS lo ha apagado, se espera.
+        if (!i2cbus.inited()) return;
+
+        // La ventana anterior lo dejó en PowerDown: despertarlo y esperar al oscilador.
+        if (pn532.poweredDown()) {
+          if (pn532.wakeUp()) nfcState = NFC_WAKING;
+          return;
+        }
+
+        // SAMConfig (modo normal) tras inicializar o despertar el PN532.
+        if (nfcNeedsConfig) {
+          const uint8_t cmd[] = { KyberPN532::CMD_SAM_CONFIGURATION, 0x01, 0x14, 0x01 };
+          if (pn532.send(cmd, sizeof(cmd), 0, 100)) {
+            nfcState = NFC_CONFIGURING;
+          }
+          return;
+        }
+
+        KYBER_TIME_PHASE(KYBER_PHASE_DETECT);
+
+        // Con IRQ y la cámara vacía, dejar que el PN532 busque solo. Con un cristal
+        // dentro se sigue sondeando para detectar cuándo se retira.
+        if (pn532.hasIRQ() && !tagCurrentlyPresent) {
+          // InAutoPoll: sin límite de sondeos, tipo Mifare/NTAG a 106 kbps.
+          const uint8_t cmd[] = { KyberPN532::CMD_IN_AUTO_POLL, 0xFF, NFC_AUTOPOLL_PERIOD, 0x10 };
+          if (pn532.send(cmd, sizeof(cmd), 15, 0)) {
+            nfcState = NFC_AUTOPOLLING;
+            metrics.addPoll();
+          }
+          return;
+        }
+
+        // InListPassiveTarget: hasta KYBER_MAX_CRYSTALS targets, ISO14443A a 106 kbps.
+        // Un solo sondeo cubre los dos cristales.
+        const uint8_t cmd[] = { KyberPN532::CMD_IN_LIST_PASSIVE_TARGET, KYBER_MAX_CRYSTALS, KyberPN532::BAUD_ISO14443A };
+        uint8_t expected = KYBER_MAX_CRYSTALS > 1 ? KyberPN532::MAX_RESPONSE : 13;
+        if (pn532.send(cmd, sizeof(cmd), expected, 100, true)) {
+          nfcState = NFC_DETECTING;
+          metrics.addPoll();
+        }
+        return;
+      }
+
+      case NFC_WAKING: {
+        if (!pn532.awake()) return;
+        nfcState = NFC_IDLE;
+        lastCheckTime = millis() - pollInterval;   // El SAMConfig, en la siguiente pasada.
+        return;
+      }
+
+      case NFC_POWERING_DOWN: {
+        KyberPN532::Result result = pn532.poll();
+        if (result == KyberPN532::PN532_PENDING) return;
+        nfcState = NFC_IDLE;
+        if (pn532.poweredDown()) {
+          KYBER_INFO("-- PN532 powered down");
+        } else {
+          powerDownFailed();
+        }
+        return;
+      }
+
+      case NFC_CONFIGURING: {
+        KyberPN532::Result result = pn532.poll();
+        if (result == KyberPN532::PN532_PENDING) return;
+        nfcState = NFC_IDLE;
+        if (result == KyberPN532::PN532_READY) {
+          nfcNeedsConfig = false;
+        } else {
+          KYBER_ERROR("! PN532 SAMConfig failed");
+        }
+        return;
+      }
+
+      case NFC_DETECTING: {
+        KYBER_TIME_PHASE(KYBER_PHASE_DETECT);
+        KyberPN532::Result result = pn532.poll();
+        if (result == KyberPN532::PN532_PENDING) return;
+        nfcState = NFC_IDLE;
+
+        KyberTagCodec::Target targets[KYBER_MAX_CRYSTALS];
+        uint8_t count = 0;
+        if (result == KyberPN532::PN532_READY) {
+          count = KyberTagCodec::parseTargets(pn532.response(), pn532.responseLength(), pn532.truncated(),
+                                              targets, KYBER_MAX_CRYSTALS);
+        }
+        onTargets(targets, count);
+        return;
+      }
+
+      case NFC_AUTOPOLLING: {
+        KYBER_TIME_PHASE(KYBER_PHASE_DETECT);
+        KyberPN532::Result result = pn532.poll();
+        if (result == KyberPN532::PN532_PENDING) return;
+        nfcState = NFC_IDLE;
+
+        // NbTg, tipo, longitud y los datos del target.
+        const uint8_t* response = pn532.response();
+        uint8_t uid[7];
+        uint8_t uidLength;
+        if (result == KyberPN532::PN532_READY && pn532.responseLength() > 3 && response[0] >= 1 &&
+            KyberTagCodec::parseTarget(response + 3, pn532.responseLength() - 3, uid, &uidLength)) {
+          onTagPresent(uid, uidLength, 1);
+        }
+        return;
+      }
+
+      case NFC_READING: {
+        KYBER_TIME_PHASE(KYBER_PHASE_READ);
+        KyberPN532::Result result = pn532.poll();
+        if (result == KyberPN532::PN532_PENDING) return;
+
+        // Respuesta de InDataExchange: byte de estado seguido de los datos leídos.
+        const uint8_t* response = pn532.response();
+        if (result != KyberPN532::PN532_READY || pn532.responseLength() < 17 || response[0] != 0x00) {
+          if (readingSecond) {
+            secondReadFailed();
+          } else {
+            readFailed();
+          }
+          return;
+        }
+
+        uint8_t length = (readPage - FIRST_DATA_PAGE + PAGES_PER_READ) * 4;
+        memcpy(pageData + length - KyberTag::READ_BYTES, response + 1, KyberTag::READ_BYTES);
+
+        // Seguir leyendo solo si el formato del cristal lo pide.
+        if (KyberTagCodec::needsMore(pageData, length) && length + KyberTag::READ_BYTES <= KyberTag::MAX_BYTES) {
+          startPageRead(readPage + PAGES_PER_READ);
+          return;
+        }
+
+        nfcState = NFC_IDLE;
+        if (readingSecond) {
+          onSecondRead(length);
+          return;
+        }
+        if (!decodeNFCData(pageData, length)) {
+          // Los datos llegan íntegros (el RF lleva CRC): repetir no los arregla.
+          markFailed(KyberRecorder::READ_INVALID);
+          return;
+        }
+        commitUID();
+        metrics.addRead(KyberMetrics::READ_OK);
+        recorder.add(KyberRecorder::EVENT_READ, KyberRecorder::READ_OK, lastUID, lastUIDLength,
+                     micros() - swapStartMicros);
+        int targetPreset = findPresetByName(nfcPresetName);
+        cacheCrystal(targetPreset);
+        applyCrystal(targetPreset);
+        activateCrystalLED(6000);
+        return;
+      }
+    }
+  }
+
+  // Resultado de un sondeo. Con dos cristales, el principal es el que ya se
+  // estaba usando (o leyendo); si los dos son nuevos, el primero.
+  void onTargets(const KyberTagCodec::Target* targets, uint8_t count) {
+    if (count == 0) {
+      onTagAbsent();
+      onSecondAbsent();
+      return;
+    }
+
+    uint8_t primary = 0;
+    if (count > 1 && !isPrimary(targets[0]) && isPrimary(targets[1])) primary = 1;
+
+    uint8_t uid[7];
+    uint8_t uidLength;
+    if (!primaryUID(targets[primary], uid, &uidLength)) return;
+    onTagPresent(uid, uidLength, targets[primary].tg);
+
+    if (count > 1) {
+      onSecondPresent(targets[1 - primary]);
+    } else {
+      onSecondAbsent();
+    }
+  }
+
+  bool isPrimary(const KyberTagCodec::Target& target) const {
+    return (lastUIDLength && KyberTagCodec::matchesUID(target, lastUID, lastUIDLength)) ||
+           (pendingUIDLength && KyberTagCodec::matchesUID(target, pendingUID, pendingUIDLength)) ||
+           (failedUIDLength && KyberTagCodec::matchesUID(target, failedUID, failedUIDLength));
+  }
+
+  // UID completo del principal. Si llegó cortado es uno de los ya conocidos.
+  bool primaryUID(const KyberTagCodec::Target& target, uint8_t* uid, uint8_t* uidLength) const {
+    const uint8_t* known = target.uid;
+    uint8_t knownLength = target.uidLength;
+    if (target.partial) {
+      if (lastUIDLength && KyberTagCodec::matchesUID(target, lastUID, lastUIDLength)) {
+        known = lastUID;
+        knownLength = lastUIDLength;
+      } else if (pendingUIDLength && KyberTagCodec::matchesUID(target, pendingUID, pendingUIDLength)) {
+        known = pendingUID;
+        knownLength = pendingUIDLength;
+      } else if (failedUIDLength && KyberTagCodec::matchesUID(target, failedUID, failedUIDLength)) {
+        known = failedUID;
+        knownLength = failedUIDLength;
+      } else {
+        return false;
+      }
+    }
+    memcpy(uid, known, knownLength);
+    *uidLength = knownLength;
+    return true;
+  }
+
+  void onTagPresent(uint8_t* uid, uint8_t uidLength, uint8_t tg) {
+    missCount = 0;
+
+    // Lectura interrumpida del mismo cristal: seguir desde la página que falló.
+    if (readResumePending && KyberTagCodec::sameUID(uid, uidLength, pendingUID, pendingUIDLength)) {
+      readResumePending = false;
+      metrics.addRead(KyberMetrics::READ_RETRIED);
+      KYBER_DEBUG("-- Resuming crystal read at page %u", readPage);
+      KYBER_TIME_PHASE(KYBER_PHASE_READ);
+      readTarget = tg;
+      readingSecond = false;
+      startPageRead(readPage);
+      return;
+    }
+    if (readResumePending) abortRead();   // Han cambiado el cristal a media lectura.
+
+    if (KyberTagCodec::sameUID(uid, uidLength, lastUID, lastUIDLength) ||
+        KyberTagCodec::sameUID(uid, uidLength, failedUID, failedUIDLength)) {
+      // El mismo cristal sigue (o ha vuelto a) la cámara.
+      tagCurrentlyPresent = true;
+      pollBackoff();
+      return;
+    }
+
+    KYBER_INFO("-- New Crystal Detected");
+    recorder.add(KyberRecorder::EVENT_DETECT, tg, uid, uidLength);
+    pollFast();
+    swapStartMicros = micros();
+    swapPending = true;
+    tagCurrentlyPresent = true;
+    failedUIDLength = 0;
+
+    // lastUID no cambia hasta tener el cristal entero: si la lectura falla se vuelve a intentar.
+    memcpy(pendingUID, uid, uidLength);
+    pendingUIDLength = uidLength;
+    readRetries = 0;
+
+    // Cristal conocido: aplicar directamente desde la caché sin leer páginas.
+    if (!forceRevalidate && applyCachedCrystal()) {
+      return;
+    }
+    forceRevalidate = false;
+
+    KYBER_TIME_PHASE(KYBER_PHASE_READ);
+    readTarget = tg;
+    readingSecond = false;
+    startPageRead(FIRST_DATA_PAGE);
+  }
+
+  // Segundo cristal presente. Su lectura espera a que no haya ninguna del
+  // principal en curso o pendiente de retomar (comparten pageData).
+  void onSecondPresent(const KyberTagCodec::Target& target) {
+    secondMiss = 0;
+    uint8_t keyLength = target.uidLength < SECOND_KEY_LENGTH ? target.uidLength : SECOND_KEY_LENGTH;
+    if (sameKey(target.uid, keyLength, secondUID, secondUIDLength) ||
+        sameKey(target.uid, keyLength, secondFailedUID, secondFailedUIDLength)) {
+      return;
+    }
+    if (nfcState != NFC_IDLE || readResumePending) return;
+
+    if (!sameKey(target.uid, keyLength, secondPendingUID, secondPendingUIDLength)) {
+      KYBER_INFO("-- Second Crystal Detected");
+      recorder.add(KyberRecorder::EVENT_DETECT, target.tg | KyberRecorder::SECOND, target.uid, keyLength);
+      memcpy(secondPendingUID, target.uid, keyLength);
+      secondPendingUIDLength = keyLength;
+      secondAttempts = 0;
+    }
+    KYBER_TIME_PHASE(KYBER_PHASE_READ);
+    readTarget = target.tg;
+    readingSecond = true;
+    startPageRead(FIRST_DATA_PAGE);
+  }
+
+  static bool sameKey(const uint8_t* a, uint8_t aLength, const uint8_t* b, uint8_t bLength) {
+    return aLength > 0 && KyberTagCodec::sameUID(a, aLength, b, bLength);
+  }
+
+  void onSecondRead(uint8_t length) {
+    readingSecond = false;
+    KyberTag tag;
+    if (!KyberTagCodec::decode(pageData, length, &tag)) {
+      KYBER_ERROR("! Invalid second crystal data");
+      parkSecond(KyberRecorder::READ_INVALID);
+      return;
+    }
+    metrics.addRead(KyberMetrics::READ_OK);
+    recorder.add(KyberRecorder::EVENT_READ, KyberRecorder::READ_OK | KyberRecorder::SECOND,
+                 secondPendingUID, secondPendingUIDLength);
+    memcpy(secondUID, secondPendingUID, secondPendingUIDLength);
+    secondUIDLength = secondPendingUIDLength;
+    secondPendingUIDLength = 0;
+    memcpy(secondColor, tag.color, sizeof(secondColor));
+    KYBER_INFO("-- Second crystal (%u,%u,%u)", secondColor[0], secondColor[1], secondColor[2]);
+    applySecondCrystal();
+  }
+
+  // Sin resume: el segundo cristal se vuelve a leer entero en el siguiente sondeo.
+  void secondReadFailed() {
+    readingSecond = false;
+    nfcState = NFC_IDLE;
+    if (++secondAttempts < KYBER_READ_RETRIES) {
+      metrics.addRead(KyberMetrics::READ_RETRIED);
+      recorder.add(KyberRecorder::EVENT_READ, KyberRecorder::READ_RETRY | KyberRecorder::SECOND,
+                   secondPendingUID, secondPendingUIDLength);
+      return;
+    }
+    KYBER_ERROR("! Error reading second crystal %u", readPage);
+    parkSecond(KyberRecorder::READ_FAILED);
+  }
+
+  void parkSecond(uint8_t code) {
+    recorder.add(KyberRecorder::EVENT_READ, code | KyberRecorder::SECOND, secondPendingUID, secondPendingUIDLength);
+    memcpy(secondFailedUID, secondPendingUID, secondPendingUIDLength);
+    secondFailedUIDLength = secondPendingUIDLength;
+    secondPendingUIDLength = 0;
+    metrics.addRead(KyberMetrics::READ_ABORTED);
+  }
+
+  void onSecondAbsent() {
+    if (!secondUIDLength && !secondFailedUIDLength && !secondPendingUIDLength) return;
+    if (++secondMiss < KYBER_PRESENCE_MISSES) return;
+    secondMiss = 0;
+    secondFailedUIDLength = 0;
+    secondPendingUIDLength = 0;
+    if (secondUIDLength) {
+      KYBER_INFO("-- Second Crystal Removed");
+      recorder.add(KyberRecorder::EVENT_REMOVED, KyberRecorder::SECOND, secondUID, secondUIDLength);
+      secondUIDLength = 0;
+      applySecondCrystal();
+    }
+  }
+
+  // Vuelve a aplicar el cristal principal con (o sin) el color del segundo,
+  // respetando un preset pendiente de un cambio con el filo encendido.
+  void applySecondCrystal() {
+    if (!lastUIDLength) return;
+    applyCrystal(liveApplyPending ? livePreset : current_preset_.preset_num);
+  }
+
+  void commitUID() {
+    memcpy(lastUID, pendingUID, pendingUIDLength);
+    lastUIDLength = pendingUIDLength;
+    pendingUIDLength = 0;
+  }
+
+  // READ fallido (acoplamiento justo de la antena, cristal moviéndose...). El
+  // siguiente sondeo vuelve a seleccionar el cristal y, si es el mismo, la
+  // lectura sigue desde la página que falló, hasta KYBER_READ_RETRIES veces.
+  void readFailed() {
+    nfcState = NFC_IDLE;
+    if (readRetries < KYBER_READ_RETRIES) {
+      readRetries++;
+      KYBER_DEBUG("! Crystal read failed at page %u, retry %u", readPage, readRetries);
+      recorder.add(KyberRecorder::EVENT_READ, KyberRecorder::READ_RETRY, pendingUID, pendingUIDLength,
+                   micros() - swapStartMicros);
+      readResumePending = true;
+      pollFast();
+      return;
+    }
+    KYBER_ERROR("! Error reading crystal %u", readPage);
+    markFailed(KyberRecorder::READ_FAILED);
+  }
+
+  // No se vuelve a leer este cristal hasta que se retire: acota el tiempo de
+  // bus que puede gastar un cristal defectuoso.
+  void markFailed(uint8_t code) {
+    memcpy(failedUID, pendingUID, pendingUIDLength);
+    failedUIDLength = pendingUIDLength;
+    abortRead(code);
+    pollBackoff();
+  }
+
+  void abortRead(uint8_t code = KyberRecorder::READ_ABORTED) {
+    recorder.add(KyberRecorder::EVENT_READ, code, pendingUID, pendingUIDLength, micros() - swapStartMicros);
+    readResumePending = false;
+    swapPending = false;
+    pendingUIDLength = 0;
+    metrics.addRead(KyberMetrics::READ_ABORTED);
+  }
+
+  bool applyCachedCrystal() {
+    const KyberCrystalCache::Entry* entry = crystalCache.lookup(pendingUID, pendingUIDLength);
+    if (!entry) return false;
+
+    // Si el preset guardado ya no existe o la configuración ha cambiado y en su
+    // índice hay otro preset, volver a leer el cristal.
+    if (entry->preset >= current_config->num_presets ||
+        presetNameHash(entry->preset) != entry->presetHash) {
+      crystalCache.remove(pendingUID, pendingUIDLength);
+      return false;
+    }
+
+    KYBER_INFO("-- Known crystal (cache)");
+    commitUID();
+    recorder.add(KyberRecorder::EVENT_READ, KyberRecorder::READ_CACHED, lastUID, lastUIDLength,
+                 micros() - swapStartMicros);
+    memcpy(nfcTag.color, entry->color, sizeof(nfcTag.color));
+    memcpy(nfcTag.owner, entry->owner, KyberCrystalCache::OWNER_LENGTH);
+    nfcTag.owner[KyberCrystalCache::OWNER_LENGTH] = '\0';
+    nfcTag.flags = entry->flags;
+    nfcTag.bladeColorCount = entry->bladeColorCount;
+    memcpy(nfcTag.bladeColors, entry->bladeColors, sizeof(nfcTag.bladeColors));
+    strncpy(nfcPresetName, current_config->presets[entry->preset].name, sizeof(nfcPresetName) - 1);
+    nfcPresetName[sizeof(nfcPresetName) - 1] = '\0';
+
+    applyCrystal(entry->preset);
+    activateCrystalLED(6000);
+    return true;
+  }
+
+  // Guarda el cristal recién leído en la caché. Se persiste con el resto del estado.
+  void cacheCrystal(int targetPreset) {
+    crystalCache.store(lastUID, lastUIDLength, targetPreset, presetNameHash(targetPreset), nfcTag);
+  }
+
+  // Hash del nombre del preset en la configuración actual (0 si no está en ella).
+  uint32_t presetNameHash(int preset) const {
+    if (preset < 0 || preset >= (int)current_config->num_presets) return 0;
+    return KyberPresetMatch::nameHash(current_config->presets[preset].name);
+  }
+
+  bool statePending() const {
+    return presetSavePending || stateSavePending || journal.pending() || crystalCache.dirty();
+  }
+
+  // Escribe en la SD lo que quede pendiente: presets.ini, el diario y la caché.
+  // Se llama con el filo apagado, tras KYBER_FLUSH_DELAY sin cambios ni
+  // encendidos y al cerrar la ventana NFC.
+  void flushCrystalState() {
+    if (!statePending()) return;
+    KYBER_TIME_PHASE(KYBER_PHASE_SD);
+    uint32_t saveStart = micros();
+    bool saved = true;
+
+    if (presetSavePending) {
+      presetSavePending = false;
+      if (current_preset_.preset_num == journal.state().preset) {
+        KYBER_DEBUG("-- Saving to presets.ini...");
+        writeStyleArgs();
+        current_preset_.Save();
+        metrics.addSDWrite();
+        heavyLoop = true;
+      }
+    }
+
+    #ifdef SAVE_PRESET
+    if (stateSavePending) {
+      stateSavePending = false;
+      SaveState(current_preset_.preset_num);
+      metrics.addSDWrite();
+      heavyLoop = true;
+    }
+    #endif
+
+    #ifdef ENABLE_SD
+    if (journal.pending()) {
+      if (journal.flush(JOURNAL_FILE, JOURNAL_FILE_ALT)) {
+        KYBER_INFO("-- Saved current preset: %u", journal.state().preset);
+      } else {
+        saved = false;
+      }
+      metrics.addSDWrite();
+      heavyLoop = true;
+    }
+    if (crystalCache.dirty()) {
+      if (!crystalCache.save(CACHE_FILE)) saved = false;
+      metrics.addSDWrite();
+      heavyLoop = true;
+    }
+    #endif
+    recorder.add(KyberRecorder::EVENT_SAVE, saved ? KyberRecorder::SAVE_OK : KyberRecorder::SAVE_FAILED,
+                 lastUID, lastUIDLength, micros() - saveStart);
+  }
+
+  void onTagAbsent() {
+    if (!tagCurrentlyPresent) {
+      pollBackoff();
+      return;
+    }
+    // Un sondeo fallido suelto no es una retirada: confirmarlo enseguida.
+    if (++missCount < KYBER_PRESENCE_MISSES) {
+      pollFast();
+      return;
+    }
+    KYBER_INFO("-- Crystal Removed");
+    recorder.add(KyberRecorder::EVENT_REMOVED, 0, lastUID, lastUIDLength);
+    tagCurrentlyPresent = false;
+    missCount = 0;
+    failedUIDLength = 0;
+    if (readResumePending) abortRead();
+    pollFast();
+  }
+
+  // Lanza un READ de NTAG2xx con InDataExchange: devuelve 4 páginas desde 'page'.
+  void startPageRead(uint8_t page) {
+    const uint8_t cmd[] = { KyberPN532::CMD_IN_DATA_EXCHANGE, readTarget, KyberPN532::NTAG_READ, page };
+    readPage = page;
+    if (pn532.send(cmd, sizeof(cmd), 17, 50)) {
+      nfcState = NFC_READING;
+    } else if (readingSecond) {
+      secondReadFailed();
+    } else {
+      readFailed();
+    }
+  }
+  
+  void activateCrystalLED(int durationMs) {
+    uint32_t r16 = (uint32_t)nfcTag.color[0] * 257;
+    uint32_t g16 = (uint32_t)nfcTag.color[1] * 257;
+    uint32_t b16 = (uint32_t)nfcTag.color[2] * 257;
+    // El cristal puede elegir su propio efecto (flags, bits 0-1).
+    uint8_t pattern = nfcTag.flags & KyberTag::FLAG_PATTERN_MASK;
+    pattern = pattern ? pattern - 1 : CRYSTAL_PATTERN;
+    
+    KYBER_DEBUG("-- Activating crystal LED");
+    
+    if (current_config && current_config->blade2) {
+      // Si ya estaba montado basta con rearmarlo.
+      CrystalLEDStyle* crystal = crystalStyle();
+      if (!crystal) {
+        crystal = new CrystalLEDStyle();
+        crystal->cover(current_config->blade2);
+        recorder.add(KyberRecorder::EVENT_LED, 1, lastUID, lastUIDLength);
+      }
+      crystal->arm(r16, g16, b16, durationMs, pattern);
+      crystalLEDOnTime = millis();
+      
+      KYBER_DEBUG("-- Crystal LED active");
+    }
+  }
+
+  void deactivateCrystalLED() {
+    CrystalLEDStyle* crystal = crystalStyle();
+    if (crystal && current_config && current_config->blade2) {
+      KYBER_DEBUG("-- Deactivating crystal LED");
+      
+      // Quitamos el estilo del cristal y restauramos el del preset.
+      crystal->uncover(current_config->blade2);
+      delete crystal;
+      recorder.add(KyberRecorder::EVENT_LED, 0, lastUID, lastUIDLength, KyberRecorder::fromMs(millis() - crystalLEDOnTime));
+      
+      KYBER_DEBUG("-- Crystal LED off");
+    }
+  }
+  
+  // Decodifica los datos leídos del cristal (v1 o v2, ver kyber_tag.h).
+  bool decodeNFCData(const uint8_t* data, uint8_t length) {
+    uint8_t version = KyberTagCodec::decode(data, length, &nfcTag);
+    if (!version) {
+      KYBER_ERROR("! Invalid crystal data");
+      strcpy(nfcPresetName, DEFAULT_PRESET_NAME);
+      return false;
+    }
+    KYBER_DEBUG("-- Crystal format v%u, %u bytes", version, length);
+
+    if (nfcTag.name[0]) {
+      strcpy(nfcPresetName, nfcTag.name);
+    } else {
+      strcpy(nfcPresetName, DEFAULT_PRESET_NAME);
+    }
+    return true;
+  }
+
+  int findPresetByName(const char* presetName) {
+    int index = presetIndex.find(presetName);
+    if (index != KyberPresetIndex::NOT_FOUND) {
+      KYBER_DEBUG("-- Found preset '%s' at index %d", presetName, index);
+      return index;
+    }
+    
+    KYBER_ERROR("! Preset '%s' not found, using default (0)", presetName);
+    return 0;
+  }
+  
+  // Un cristal del mismo preset solo cambia los argumentos de color de los
+  // estilos en marcha. Un preset distinto se carga con el filo apagado; si
+  // está encendido, el color cambia ya y el preset al apagarlo.
+  void applyCrystal(int targetPreset) {
+    if (SaberBase::IsOn() && targetPreset != current_preset_.preset_num) {
+      KYBER_TIME_PHASE(KYBER_PHASE_APPLY);
+      uint32_t applyStart = micros();
+      setStyleArgs(KYBER_LIVE_FADE_MS);
+      liveApplyPending = true;
+      livePreset = targetPreset;
+      lastSwapTime = millis();
+      recorder.add(KyberRecorder::EVENT_APPLY, KyberRecorder::APPLY_LIVE, lastUID, lastUIDLength,
+                   micros() - applyStart);
+      KYBER_INFO("-- Live color: RGB(%u,%u,%u)", nfcTag.color[0], nfcTag.color[1], nfcTag.color[2]);
+      KYBER_INFO("-- Preset %d (%s) will load when the blade is off", targetPreset, nfcPresetName);
+      return;
+    }
+    applyNFCSettings(targetPreset);
+  }
+
+  // Colores del cristal en kyber_style_args: el principal y los de cada filo (v2).
+  void setStyleArgs(uint16_t fadeMs) {
+    KyberStyleArg args[2 + KYBER_TAG_BLADE_COLORS];
+    BladeBase* blades[2 + KYBER_TAG_BLADE_COLORS];
+    uint8_t count = 0;
+
+    args[count].blade = MAIN_BLADE;
+    args[count].arg = 1;
+    memcpy(args[count].rgb, nfcTag.color, 3);
+    blades[count] = bladeByNumber(MAIN_BLADE);
+    count++;
+    // Segundo cristal de la cámara.
+    if (secondUIDLength) {
+#ifdef KYBER_SECOND_CRYSTAL_BLEND
+      for (uint8_t c = 0; c < 3; c++) {
+        args[0].rgb[c] = (nfcTag.color[c] + secondColor[c]) / 2;
+      }
+#else
+      args[count].blade = MAIN_BLADE;
+      args[count].arg = KYBER_SECOND_CRYSTAL_ARG;
+      memcpy(args[count].rgb, secondColor, 3);
+      blades[count] = bladeByNumber(MAIN_BLADE);
+      count++;
+#endif
+    }
+    // Pueden sustituir también al del principal.
+    for (uint8_t i = 0; i < nfcTag.bladeColorCount; i++) {
+      const KyberBladeColor& bc = nfcTag.bladeColors[i];
+      args[count].blade = bc.blade;
+      args[count].arg = 1;
+      memcpy(args[count].rgb, bc.color, 3);
+      blades[count] = bladeByNumber(bc.blade);
+      count++;
+    }
+    kyber_style_args.apply(args, blades, count, fadeMs);
+  }
+
+  static BladeBase* bladeByNumber(int blade) {
+    if (!current_config) return nullptr;
+#define KYBER_BLADE_BY_NUMBER(N) if (blade == N) return current_config->blade##N;
+    ONCEPERBLADE(KYBER_BLADE_BY_NUMBER)
+#undef KYBER_BLADE_BY_NUMBER
+    return nullptr;
+  }
+
+  void applyNFCSettings(int targetPreset) {
+    KYBER_TIME_PHASE(KYBER_PHASE_APPLY);
+    heavyLoop = true;
+    uint32_t applyStart = micros();
+    const uint8_t* color = nfcTag.color;
+    liveApplyPending = false;
+
+    KYBER_INFO("-- Applying color: RGB(%u,%u,%u)", color[0], color[1], color[2]);
+    KYBER_INFO("-- Target preset: %d (%s)", targetPreset, nfcPresetName);
+
+    // Los colores van en binario a los estilos; el texto del preset solo se
+    // escribe al guardar presets.ini.
+    setStyleArgs(SaberBase::IsOn() ? KYBER_LIVE_FADE_MS : 0);
+
+    uint32_t buildStart = micros();
+    bool rebuild = targetPreset != current_preset_.preset_num;
+    if (rebuild) {
+      // Desmontar el estilo del cristal antes de liberar los estilos del preset.
+      deactivateCrystalLED();
+      FreeBladeStyles();
+      current_preset_.SetPreset(targetPreset);
+      // Con los colores ya en el texto del preset, los estilos con RgbArg
+      // salen bien construidos y basta con una sola construcción.
+      writeStyleArgs();
+      AllocateBladeStyles();
+      chdir(current_preset_.font);
+      #ifdef SAVE_PRESET
+      stateSavePending = true;   // Se guarda con el resto en flushCrystalState().
+      #endif
+      SaberBase::DoNewFont();
+    } else if (!kyber_style_args.users()) {
+      // Mismo preset con estilos sin KyberRgbArg: el color solo llega a través
+      // del texto del preset y hay que reconstruirlos, con el filo encendido al
+      // apagarlo.
+      if (SaberBase::IsOn()) {
+        liveApplyPending = true;
+        livePreset = targetPreset;
+      } else {
+        deactivateCrystalLED();
+        FreeBladeStyles();
+        writeStyleArgs();
+        AllocateBladeStyles();
+        rebuild = true;
+      }
+    }
+
+    if (rebuild) {
+      KYBER_DEBUG("-- Styles built in %lu us", (unsigned long)(micros() - buildStart));
+    }
+
+    // La escritura en la SD se difiere: varios cambios seguidos acaban en una sola.
+    journal.record(targetPreset, color);
+    presetSavePending = true;
+    lastSwapTime = millis();
+    // El preset ya está cargado; no hace falta recargarlo al encender.
+    needsPresetReload = false;
+    recorder.add(KyberRecorder::EVENT_APPLY, rebuild ? KyberRecorder::APPLY_REBUILD : KyberRecorder::APPLY_COLOR,
+                 lastUID, lastUIDLength, micros() - applyStart);
+
+    KYBER_INFO("-- Crystal Bonded (%u,%u,%u)  Preset: %s", color[0], color[1], color[2], nfcPresetName);
+    if (nfcTag.owner[0]) {
+      KYBER_INFO("-- Attuned to: %s", nfcTag.owner);
+    }
+  }
+
+  // Pasa a texto los argumentos del cristal: un estilo "builtin" por filo con color.
+  void writeStyleArgs() {
+    int preset = current_preset_.preset_num;
+    // "builtin" solo puede referirse a los presets compilados en la configuración.
+    if (preset >= (int)current_config->num_presets) {
+      KYBER_INFO("-- Preset only on SD, keeping its style");
+      return;
+    }
+    for (uint8_t blade = 1; blade <= NUM_BLADES; blade++) {
+      if (!kyber_style_args.has(blade)) continue;
+      char styleString[64];
+      if (!kyber_style_args.format(preset, blade, styleString, sizeof(styleString))) continue;
+      KYBER_DEBUG("-- Style: %s", styleString);
+      current_preset_.SetStyle(blade, LSPtr<char>(mkstr(styleString)));
+    }
+  }
+};
+
 #endif
\ No newline at end of file
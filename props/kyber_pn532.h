@@ -0,0 +1,322 @@
+#ifndef PROPS_KYBER_PN532_H
+#define PROPS_KYBER_PN532_H
+
+#include <Wire.h>
+#include "kyber_i2c.h"
+
+// =========================================
+// KYBER PN532 - Transceptor no bloqueante
+// =========================================
+// Las funciones de la librería de Adafruit esperaban la respuesta del módulo
+// con delay(10) entre consultas, lo que bloqueaba el Loop() durante decenas de
+// milisegundos. KyberPN532 habla directamente con el PN532 por Wire y divide
+// cada comando en fases: se envía la trama y se vuelve, y en las siguientes
+// llamadas a poll() se consulta una sola vez el byte de estado del PN532
+// hasta que el ACK y la respuesta están listos.
+// Si hay pin IRQ cableado, la comprobación es una lectura digital y el bus
+// I2C queda libre hasta que el módulo tiene algo que entregar.
+// startPowerDown() envía, como un comando más, el PowerDown que apaga el campo
+// RF y el oscilador hasta el siguiente acceso por I2C; wakeUp() lo despierta
+// y awake() indica cuándo ha pasado el arranque del oscilador.
+// Cada acceso al bus pide paso a kyber_i2c (kyber_i2c.h); si el IMU está a
+// punto de leer, el acceso se deja para una llamada posterior a poll().
+class KyberPN532 {
+public:
+  enum Result {
+    PN532_PENDING,  // El comando sigue en curso.
+    PN532_READY,    // Respuesta recibida y validada.
+    PN532_FAILED    // Error de bus, trama inválida o timeout.
+  };
+
+  static constexpr uint8_t MAX_COMMAND = 16;
+  static constexpr uint8_t MAX_RESPONSE = 22;  // 32 bytes de trama, el buffer de Wire.
+
+  static constexpr uint8_t NO_IRQ = 255;
+
+  // Comandos del PN532 que usa el prop (manual de usuario del PN532, 7.2-7.3).
+  static constexpr uint8_t CMD_GET_FIRMWARE_VERSION = 0x02;
+  static constexpr uint8_t CMD_SAM_CONFIGURATION = 0x14;
+  static constexpr uint8_t CMD_POWER_DOWN = 0x16;
+  static constexpr uint8_t CMD_RF_CONFIGURATION = 0x32;
+  static constexpr uint8_t CMD_IN_DATA_EXCHANGE = 0x40;
+  static constexpr uint8_t CMD_IN_LIST_PASSIVE_TARGET = 0x4A;
+  static constexpr uint8_t CMD_IN_AUTO_POLL = 0x60;
+
+  static constexpr uint8_t BAUD_ISO14443A = 0x00;  // 106 kbps tipo A (NTAG2xx).
+  static constexpr uint8_t NTAG_READ = 0x30;       // READ de NTAG2xx/MIFARE: 4 páginas.
+
+  explicit KyberPN532(uint8_t irqPin = NO_IRQ)
+    : irqPin_(irqPin), state_(STATE_IDLE), frameLength_(0), command_(0), responseLength_(0),
+      expectedLength_(0), startTime_(0), timeout_(0), poweredDown_(false) {}
+
+  bool hasIRQ() const { return irqPin_ != NO_IRQ; }
+
+  // Configura el pin IRQ. La salida del PN532 es en drenador abierto y baja
+  // cuando hay respuesta. Se llama antes del primer comando, con el bus ya
+  // arrancado por ProffieOS (i2cbus.inited()).
+  void begin() {
+    if (hasIRQ()) pinMode(irqPin_, INPUT_PULLUP);
+  }
+
+  bool poweredDown() const { return poweredDown_; }
+
+  // PowerDown con despertar por I2C. Se completa con poll() como cualquier
+  // otro comando; con la respuesta correcta, poweredDown() pasa a true.
+  bool startPowerDown() {
+    abort();
+    const uint8_t cmd[] = { CMD_POWER_DOWN, WAKEUP_I2C };
+    return send(cmd, sizeof(cmd), 1, 20);
+  }
+
+  // Cualquier acceso a su dirección despierta al PN532. Devuelve false si el
+  // bus está ocupado: se reintenta en la siguiente pasada.
+  bool wakeUp() {
+    if (!poweredDown_) return true;
+    if (!kyber_i2c.acquire(0, true)) return false;
+    Wire.beginTransmission(I2C_ADDRESS);
+    Wire.endTransmission();
+    kyber_i2c.release();
+    poweredDown_ = false;
+    wakeStart_ = micros();
+    waking_ = true;
+    return true;
+  }
+
+  // El oscilador tarda en arrancar tras wakeUp(): hasta entonces el PN532 no
+  // responde con ACK.
+  bool awake() {
+    if (waking_ && micros() - wakeStart_ < WAKEUP_US) return false;
+    waking_ = false;
+    return true;
+  }
+
+  bool busy() const { return state_ != STATE_IDLE; }
+
+  // Prepara un comando para el PN532 y lo envía si el bus está libre; si no,
+  // se envía en una llamada posterior a poll(). Vuelve inmediatamente.
+  // expectedLength es el número de bytes de datos que se esperan en la respuesta.
+  // Con timeoutMs = 0 se espera indefinidamente (InAutoPoll).
+  // truncate: la respuesta puede no caber en MAX_RESPONSE (InListPassiveTarget
+  // con dos targets); se aceptan los primeros bytes sin comprobar el DCS.
+  bool send(const uint8_t* cmd, uint8_t len, uint8_t expectedLength, uint32_t timeoutMs,
+            bool truncate = false) {
+    if (len == 0 || len > MAX_COMMAND) return false;
+
+    uint8_t* frame = frame_;
+    uint8_t n = 0;
+    uint8_t checksum = HOST_TO_PN532;
+
+    frame[n++] = PREAMBLE;
+    frame[n++] = STARTCODE1;
+    frame[n++] = STARTCODE2;
+    frame[n++] = len + 1;
+    frame[n++] = (uint8_t)(~(len + 1) + 1);
+    frame[n++] = HOST_TO_PN532;
+    for (uint8_t i = 0; i < len; i++) {
+      frame[n++] = cmd[i];
+      checksum += cmd[i];
+    }
+    frame[n++] = (uint8_t)(~checksum + 1);
+    frame[n++] = POSTAMBLE;
+    frameLength_ = n;
+
+    command_ = cmd[0];
+    responseLength_ = 0;
+    expectedLength_ = expectedLength > MAX_RESPONSE ? MAX_RESPONSE : expectedLength;
+    truncate_ = truncate;
+    truncated_ = false;
+    startTime_ = millis();
+    timeout_ = timeoutMs;
+    state_ = STATE_SEND;
+    return poll() != PN532_FAILED;
+  }
+
+  // Avanza el comando en curso como mucho una fase (una transferencia I2C).
+  // Nunca espera al módulo ni al bus.
+  Result poll() {
+    switch (state_) {
+      case STATE_SEND:
+        if (abortPending_) {
+          if (!sendAbort()) return checkTimeout();
+          return PN532_PENDING;
+        }
+        if (!kyber_i2c.acquire(frameLength_)) return checkTimeout();
+        if (!writeFrame()) {
+          state_ = STATE_IDLE;
+          return PN532_FAILED;
+        }
+        state_ = STATE_WAIT_ACK;
+        return PN532_PENDING;
+
+      case STATE_WAIT_ACK:
+        if (!isReady()) return checkTimeout();
+        if (!kyber_i2c.acquire(ACK_LENGTH + 1)) return checkTimeout();
+        if (!readAck()) {
+          abort();
+          return PN532_FAILED;
+        }
+        state_ = STATE_WAIT_RESPONSE;
+        return PN532_PENDING;
+
+      case STATE_WAIT_RESPONSE:
+        if (!isReady()) return checkTimeout();
+        if (!kyber_i2c.acquire(expectedLength_ + 10)) return checkTimeout();
+        state_ = STATE_IDLE;
+        return readResponse() ? PN532_READY : PN532_FAILED;
+
+      default:
+        return PN532_FAILED;
+    }
+  }
+
+  // Cancela el comando en curso. Enviar una trama ACK al PN532 aborta el
+  // comando actual; si el bus está ocupado, la trama sale antes del siguiente comando.
+  void abort() {
+    if (state_ != STATE_IDLE && state_ != STATE_SEND) {
+      abortPending_ = true;
+      sendAbort();
+    }
+    state_ = STATE_IDLE;
+  }
+
+  // Datos de la última respuesta (sin TFI ni código de comando).
+  const uint8_t* response() const { return response_; }
+  uint8_t responseLength() const { return responseLength_; }
+  // La última respuesta llegó cortada (ver send()).
+  bool truncated() const { return truncated_; }
+
+private:
+  static constexpr uint8_t WAKEUP_I2C = 0x80;  // WakeUpEnable: bit 7, interfaz I2C.
+  static constexpr uint32_t WAKEUP_US = 2000;  // Arranque del oscilador tras despertar.
+  static constexpr uint8_t I2C_ADDRESS = 0x24;  // 0x48 en 8 bits.
+  static constexpr uint8_t I2C_READY = 0x01;    // Bit 0 del byte de estado.
+
+  // Trama normal: 00 00 FF LEN LCS TFI datos DCS 00.
+  static constexpr uint8_t PREAMBLE = 0x00;
+  static constexpr uint8_t STARTCODE1 = 0x00;
+  static constexpr uint8_t STARTCODE2 = 0xFF;
+  static constexpr uint8_t POSTAMBLE = 0x00;
+  static constexpr uint8_t HOST_TO_PN532 = 0xD4;
+  static constexpr uint8_t PN532_TO_HOST = 0xD5;
+  static constexpr uint8_t ACK_LENGTH = 6;
+  static constexpr uint8_t ACK_FRAME[ACK_LENGTH] = { 0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00 };
+
+  enum State : uint8_t {
+    STATE_IDLE,
+    STATE_SEND,         // Trama preparada, esperando hueco en el bus.
+    STATE_WAIT_ACK,
+    STATE_WAIT_RESPONSE
+  };
+
+  Result checkTimeout() {
+    if (timeout_ != 0 && millis() - startTime_ >= timeout_) {
+      abort();
+      return PN532_FAILED;
+    }
+    return PN532_PENDING;
+  }
+
+  bool sendAbort() {
+    if (!kyber_i2c.acquire(ACK_LENGTH, true)) return false;
+    Wire.beginTransmission(I2C_ADDRESS);
+    Wire.write(ACK_FRAME, ACK_LENGTH);
+    Wire.endTransmission();
+    kyber_i2c.release();
+    abortPending_ = false;
+    return true;
+  }
+
+  bool writeFrame() {
+    Wire.beginTransmission(I2C_ADDRESS);
+    Wire.write(frame_, frameLength_);
+    bool ok = Wire.endTransmission() == 0;
+    kyber_i2c.release();
+    return ok;
+  }
+
+  // La línea IRQ baja cuando hay respuesta. Sin IRQ se lee el byte de estado (bit 0 = lista).
+  bool isReady() {
+    if (hasIRQ()) return digitalRead(irqPin_) == LOW;
+    if (!kyber_i2c.acquire(1)) return false;
+    bool ready = Wire.requestFrom((uint8_t)I2C_ADDRESS, (uint8_t)1) == 1 &&
+                 (Wire.read() & I2C_READY) != 0;
+    kyber_i2c.release();
+    return ready;
+  }
+
+  bool readAck() {
+    uint8_t buffer[ACK_LENGTH + 1];
+    if (!readRaw(buffer, sizeof(buffer))) return false;
+    return memcmp(buffer + 1, ACK_FRAME, ACK_LENGTH) == 0;
+  }
+
+  // Lee y valida una trama de respuesta: estado, 00 00 FF, LEN, LCS, D5, CMD+1, datos, DCS.
+  bool readResponse() {
+    uint8_t buffer[MAX_RESPONSE + 10];
+    uint8_t total = expectedLength_ + 10;
+    if (!readRaw(buffer, total)) return false;
+
+    // Buscar el código de inicio (00 FF) tras el byte de estado.
+    uint8_t i = 1;
+    while (i + 1 < total && !(buffer[i] == STARTCODE1 && buffer[i + 1] == STARTCODE2)) i++;
+    if (i + 5 >= total) return false;
+
+    uint8_t len = buffer[i + 2];
+    if ((uint8_t)(len + buffer[i + 3]) != 0) return false;
+    if (len < 2) return false;
+
+    const uint8_t* body = buffer + i + 4;
+    if (body[0] != PN532_TO_HOST || body[1] != (uint8_t)(command_ + 1)) return false;
+
+    // La trama sigue más allá de lo leído.
+    if (i + 4 + len >= total) {
+      if (!truncate_) return false;
+      truncated_ = true;
+      responseLength_ = total - (i + 4) - 2;
+      if (responseLength_ > MAX_RESPONSE) responseLength_ = MAX_RESPONSE;
+      memcpy(response_, body + 2, responseLength_);
+      return true;
+    }
+
+    uint8_t checksum = 0;
+    for (uint8_t j = 0; j <= len; j++) checksum += body[j];
+    if (checksum != 0) return false;
+
+    responseLength_ = len - 2;
+    if (responseLength_ > MAX_RESPONSE) responseLength_ = MAX_RESPONSE;
+    memcpy(response_, body + 2, responseLength_);
+    if (command_ == CMD_POWER_DOWN && responseLength_ > 0 && response_[0] == 0x00) poweredDown_ = true;
+    return true;
+  }
+
+  // Lectura concedida antes por kyber_i2c.acquire().
+  bool readRaw(uint8_t* buffer, uint8_t len) {
+    bool ok = Wire.requestFrom((uint8_t)I2C_ADDRESS, len) == len;
+    if (ok) {
+      for (uint8_t i = 0; i < len; i++) buffer[i] = Wire.read();
+    }
+    kyber_i2c.release();
+    return ok;
+  }
+
+  uint8_t irqPin_;
+  State state_;
+  uint8_t frame_[MAX_COMMAND + 8];
+  uint8_t frameLength_;
+  uint8_t command_;
+  uint8_t response_[MAX_RESPONSE];
+  uint8_t responseLength_;
+  uint8_t expectedLength_;
+  bool truncate_ = false;
+  bool truncated_ = false;
+  bool abortPending_ = false;   // Trama de abortar pendiente de enviar (bus ocupado).
+  uint32_t startTime_;
+  uint32_t timeout_;
+  bool poweredDown_;
+  bool waking_ = false;
+  uint32_t wakeStart_ = 0;
+};
+
+constexpr uint8_t KyberPN532::ACK_FRAME[KyberPN532::ACK_LENGTH];
+
+#endif
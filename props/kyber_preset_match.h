@@ -0,0 +1,109 @@
+#ifndef PROPS_KYBER_PRESET_MATCH_H
+#define PROPS_KYBER_PRESET_MATCH_H
+
+// =========================================
+// KYBER PRESET MATCH - Búsqueda de presets por nombre
+// =========================================
+// La parte de KyberPresetIndex que no depende de ProffieOS: comparar nombres
+// sin distinguir mayúsculas, ordenar los índices de una tabla de presets y
+// buscar el nombre exacto o un prefijo. PRESET es cualquier tipo con un campo
+// 'name', así que compila igual para la placa que en el PC.
+// No reserva memoria: el orden va en el array que se le pasa. Con la tabla
+// ordenada cada búsqueda hace O(log n) comparaciones, más las de los presets
+// que comparten el prefijo buscado. Las dos búsquedas devuelven lo mismo: el
+// nombre exacto o, si no, el primer preset de la configuración con ese prefijo.
+
+#include <stddef.h>
+#include <stdint.h>
+
+class KyberPresetMatch {
+public:
+  static constexpr int NOT_FOUND = -1;
+
+  // Comparación sin distinguir mayúsculas de, como mucho, n caracteres.
+  static int compareNoCase(const char* a, const char* b, size_t n = (size_t)-1) {
+    for (size_t i = 0; i < n; i++) {
+      int ca = toLower(a[i]);
+      int cb = toLower(b[i]);
+      if (ca != cb || ca == 0) return ca - cb;
+    }
+    return 0;
+  }
+
+  static bool startsWithNoCase(const char* str, const char* prefix) {
+    size_t n = 0;
+    while (prefix[n]) n++;
+    return n > 0 && compareNoCase(str, prefix, n) == 0;
+  }
+
+  // Hash FNV-1a de 32 bits del nombre sin distinguir mayúsculas. Identifica
+  // el preset de un índice guardado aunque la configuración cambie de orden.
+  static uint32_t nameHash(const char* name) {
+    uint32_t hash = 2166136261u;
+    for (; *name; name++) {
+      hash ^= (uint32_t)toLower(*name);
+      hash *= 16777619u;
+    }
+    return hash;
+  }
+
+  // Ordena los índices por nombre (inserción: se hace una vez y hay pocos presets).
+  template<class PRESET>
+  static void sort(const PRESET* presets, size_t count, uint8_t* order) {
+    for (size_t i = 0; i < count; i++) {
+      size_t j = i;
+      while (j > 0 && compareNoCase(presets[order[j - 1]].name, presets[i].name) > 0) {
+        order[j] = order[j - 1];
+        j--;
+      }
+      order[j] = i;
+    }
+  }
+
+  // Búsqueda binaria sobre los índices ordenados por sort().
+  template<class PRESET>
+  static int findSorted(const PRESET* presets, const uint8_t* order, size_t count, const char* name) {
+    // Primer nombre >= name.
+    size_t lo = 0, hi = count;
+    while (lo < hi) {
+      size_t mid = (lo + hi) / 2;
+      if (compareNoCase(presets[order[mid]].name, name) < 0) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    if (lo == count) return NOT_FOUND;
+
+    // Si hay coincidencia exacta, va justo ahí (sort() es estable, así que
+    // entre nombres iguales es el primero de la configuración).
+    if (compareNoCase(presets[order[lo]].name, name) == 0) return order[lo];
+
+    // Si no, los nombres con ese prefijo van seguidos y gana, como en
+    // findLinear(), el primero de la configuración.
+    int prefix = NOT_FOUND;
+    for (size_t i = lo; i < count && startsWithNoCase(presets[order[i]].name, name); i++) {
+      if (prefix == NOT_FOUND || order[i] < prefix) prefix = order[i];
+    }
+    return prefix;
+  }
+
+  // Sin índice, para tablas más grandes que él.
+  template<class PRESET>
+  static int findLinear(const PRESET* presets, size_t count, const char* name) {
+    int prefix = NOT_FOUND;
+    for (size_t i = 0; i < count; i++) {
+      const char* presetName = presets[i].name;
+      if (compareNoCase(presetName, name) == 0) return i;
+      if (prefix == NOT_FOUND && startsWithNoCase(presetName, name)) prefix = i;
+    }
+    return prefix;
+  }
+
+private:
+  static int toLower(char c) {
+    return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : (unsigned char)c;
+  }
+};
+
+#endif
@@ -0,0 +1,151 @@
+#ifndef PROPS_KYBER_PRESETS_H
+#define PROPS_KYBER_PRESETS_H
+
+// =========================================
+// KYBER PRESETS - Índice de presets por nombre
+// =========================================
+// El array presets[] se declara en la configuración después de incluir el
+// prop y sus elementos no son constexpr, así que el índice no puede generarse
+// en compilación. Se construye una sola vez por BladeConfig: los presets
+// ordenados por nombre sin distinguir mayúsculas, para buscar por búsqueda
+// binaria tanto el nombre exacto como un prefijo (los nombres de los
+// cristales v1 están limitados a 8 bytes). La búsqueda en sí está en
+// kyber_preset_match.h, que no depende de ProffieOS.
+// Si el nombre no está en la configuración compilada se busca en presets.ini,
+// por si los presets se han editado en la SD. Los nombres que tampoco están
+// ahí se recuerdan (por hash) para no volver a recorrer el fichero con cada
+// sondeo del mismo cristal.
+
+#include "kyber_preset_match.h"
+
+#ifndef KYBER_PRESET_INDEX_SIZE
+#define KYBER_PRESET_INDEX_SIZE 64
+#endif
+
+// Nombres recordados que no están ni en la configuración ni en presets.ini.
+#ifndef KYBER_PRESET_MISSES
+#define KYBER_PRESET_MISSES 4
+#endif
+
+class KyberPresetIndex {
+public:
+  static constexpr int NOT_FOUND = KyberPresetMatch::NOT_FOUND;
+
+  KyberPresetIndex() : config_(nullptr), count_(0), missCount_(0), missNext_(0) {}
+
+  // Busca por nombre exacto (sin distinguir mayúsculas) y, si no, por prefijo.
+  int find(const char* name) {
+    if (config_ != current_config || count_ != current_config->num_presets) build();
+
+    int result = count_ <= KYBER_PRESET_INDEX_SIZE ? findIndexed(name) : findLinear(name);
+#ifdef ENABLE_SD
+    if (result == NOT_FOUND) {
+      uint32_t hash = KyberPresetMatch::nameHash(name);
+      if (missed(hash)) return NOT_FOUND;
+      result = findInPresetsIni(name);
+      if (result == NOT_FOUND) addMiss(hash);
+    }
+#endif
+    return result;
+  }
+
+  // Olvida los nombres no encontrados, por si presets.ini ha cambiado.
+  void forgetMisses() {
+    missCount_ = 0;
+    missNext_ = 0;
+  }
+
+private:
+  // Ordena los índices por nombre. Se hace una vez por configuración.
+  void build() {
+    config_ = current_config;
+    count_ = current_config->num_presets;
+    forgetMisses();
+    if (count_ > KYBER_PRESET_INDEX_SIZE) return;
+    KyberPresetMatch::sort(config_->presets, count_, order_);
+  }
+
+  int findIndexed(const char* name) const {
+    return KyberPresetMatch::findSorted(config_->presets, order_, count_, name);
+  }
+
+  // Para configuraciones más grandes que el índice.
+  int findLinear(const char* name) const {
+    return KyberPresetMatch::findLinear(config_->presets, count_, name);
+  }
+
+#ifdef ENABLE_SD
+  bool missed(uint32_t hash) const {
+    for (uint8_t i = 0; i < missCount_; i++) {
+      if (misses_[i] == hash) return true;
+    }
+    return false;
+  }
+
+  void addMiss(uint32_t hash) {
+    misses_[missNext_] = hash;
+    missNext_ = (missNext_ + 1) % KYBER_PRESET_MISSES;
+    if (missCount_ < KYBER_PRESET_MISSES) missCount_++;
+  }
+
+  // Recorre presets.ini buscando líneas "name=". Cada "new_preset" abre un preset.
+  // Se lee por bloques: cada read() de la SD tiene un coste fijo alto.
+  int findInPresetsIni(const char* name) const {
+    char path[64];
+    if (config_->save_dir) {
+      snprintf(path, sizeof(path), "%s/presets.ini", config_->save_dir);
+    } else {
+      strcpy(path, "presets.ini");
+    }
+    if (!LSFS::Exists(path)) return NOT_FOUND;
+
+    File f = LSFS::Open(path);
+    if (!f) return NOT_FOUND;
+
+    int preset = -1;
+    int prefix = NOT_FOUND;
+    int result = NOT_FOUND;
+    char line[48];
+    size_t len = 0;
+    char block[128];
+    int blockLen = 0;
+    int pos = 0;
+    bool more = true;
+    while (more && result == NOT_FOUND) {
+      if (pos == blockLen) {
+        blockLen = f.read((uint8_t*)block, sizeof(block));
+        pos = 0;
+        more = blockLen > 0;
+      }
+      char c = more ? block[pos++] : '\n';
+      if (c != '\n' && c != '\r') {
+        if (len < sizeof(line) - 1) line[len++] = c;
+        continue;
+      }
+      line[len] = '\0';
+      len = 0;
+
+      if (!strcmp(line, "new_preset")) {
+        preset++;
+      } else if (preset >= 0 && !strncmp(line, "name=", 5)) {
+        if (KyberPresetMatch::compareNoCase(line + 5, name) == 0) {
+          result = preset;
+        } else if (prefix == NOT_FOUND && KyberPresetMatch::startsWithNoCase(line + 5, name)) {
+          prefix = preset;
+        }
+      }
+    }
+    f.close();
+    return result != NOT_FOUND ? result : prefix;
+  }
+#endif
+
+  const BladeConfig* config_;
+  size_t count_;
+  uint8_t order_[KYBER_PRESET_INDEX_SIZE];
+  uint32_t misses_[KYBER_PRESET_MISSES];   // Hashes (KyberPresetMatch::nameHash).
+  uint8_t missCount_;
+  uint8_t missNext_;
+};
+
+#endif
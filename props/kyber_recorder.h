@@ -0,0 +1,308 @@
+#ifndef PROPS_KYBER_RECORDER_H
+#define PROPS_KYBER_RECORDER_H
+
+// =========================================
+// KYBER RECORDER - Registro de eventos de los cristales en la SD
+// =========================================
+// Caja negra para las placas que fallan lejos de un puerto serie: cada
+// detección, lectura, aplicación, guardado, ventana NFC y encendido del LED
+// del cristal queda en un registro binario de 16 bytes con el UID, el millis()
+// del evento, una duración y un código de resultado.
+// Los registros se acumulan en RAM y se escriben por lotes, con el filo
+// apagado y como mucho una escritura por pasada de Loop(). Con el filo
+// encendido no se toca la SD; si el buffer se llena, los eventos nuevos se
+// descartan y se cuentan en un evento EVENT_DROPPED.
+// El fichero es un anillo de KYBER_RECORDER_RECORDS registros. Cada registro
+// lleva una secuencia de 24 bits y un CRC-8; al arrancar se recorre el
+// fichero, un bloque por pasada, hasta el primer salto de secuencia o
+// registro roto, que es donde sigue la escritura.
+// kyber_recorder.py lee el fichero en el PC.
+//
+// Formato del registro (little endian):
+//   0     tipo (Event)
+//   1     código (ReadCode, ApplyCode...); bit 7 = segundo cristal
+//   2-3   duración: bit 15 a 0 en us, a 1 en ms (ver duration())
+//   4-7   millis()
+//   8-11  primeros 4 bytes del UID (0 si no hay cristal)
+//   12-14 secuencia
+//   15    CRC-8 de los bytes 0-14
+
+#ifndef KYBER_RECORDER
+#define KYBER_RECORDER 1
+#endif
+
+// Registros del anillo en la SD (16 bytes cada uno).
+#ifndef KYBER_RECORDER_RECORDS
+#define KYBER_RECORDER_RECORDS 1024
+#endif
+
+// Registros en RAM a la espera de escribirse.
+#ifndef KYBER_RECORDER_BUFFER
+#define KYBER_RECORDER_BUFFER 32
+#endif
+
+// Se escribe al llegar a medio buffer o cuando el evento más antiguo lleva
+// este tiempo esperando.
+#ifndef KYBER_RECORDER_FLUSH_MS
+#define KYBER_RECORDER_FLUSH_MS 5000
+#endif
+
+class KyberRecorderFormat {
+public:
+  static constexpr uint8_t RECORD_SIZE = 16;
+  static constexpr uint8_t UID_BYTES = 4;
+  static constexpr uint32_t SEQUENCE_MASK = 0xFFFFFF;
+  static constexpr uint16_t DURATION_MS = 0x8000;
+
+  enum Event : uint8_t {
+    EVENT_BOOT = 1,      // Arranque: los millis() vuelven a empezar.
+    EVENT_DETECT,        // Cristal nuevo en la cámara. Código: Tg.
+    EVENT_READ,          // Fin de una lectura (ReadCode). Duración desde la detección.
+    EVENT_APPLY,         // Cristal aplicado (ApplyCode). Duración del trabajo.
+    EVENT_SWAP,          // Primer frame con el color nuevo. Duración desde la detección.
+    EVENT_SAVE,          // Estado escrito en la SD (SaveCode). Duración de la escritura.
+    EVENT_WINDOW_OPEN,   // PN532 despierto, empieza la ventana NFC.
+    EVENT_TIMEOUT,       // Fin de la ventana NFC (TimeoutCode). Duración de la ventana.
+    EVENT_LED,           // LED del cristal: código 1 encendido, 0 apagado (con su duración).
+    EVENT_REMOVED,       // Cristal retirado.
+    EVENT_DROPPED        // Eventos perdidos con el buffer lleno (código, saturado a 255).
+  };
+
+  enum ReadCode : uint8_t {
+    READ_OK,        // Leído entero.
+    READ_CACHED,    // Conocido: aplicado desde la caché sin leer páginas.
+    READ_RETRY,     // READ fallido, se retomará.
+    READ_FAILED,    // Reintentos agotados.
+    READ_INVALID,   // Datos del cristal inválidos.
+    READ_ABORTED    // Retirado o cambiado a media lectura.
+  };
+
+  enum ApplyCode : uint8_t {
+    APPLY_COLOR,    // Solo los colores, sin reconstruir estilos.
+    APPLY_REBUILD,  // Preset nuevo o estilos sin KyberRgbArg: estilos reconstruidos.
+    APPLY_LIVE      // Filo encendido: el preset espera al apagado.
+  };
+
+  enum SaveCode : uint8_t {
+    SAVE_OK,
+    SAVE_FAILED
+  };
+
+  enum TimeoutCode : uint8_t {
+    TIMEOUT_SLEEP,        // Ventana cerrada, PowerDown enviado.
+    TIMEOUT_SLEEP_FAILED  // El PN532 no confirmó el PowerDown (evento aparte, tras el de cierre).
+  };
+
+  static constexpr uint8_t SECOND = 0x80;
+
+  // Duración en 16 bits: en us hasta 32767 us y en ms a partir de ahí.
+  static uint16_t duration(uint32_t us) {
+    if (us < DURATION_MS) return us;
+    uint32_t ms = us / 1000;
+    return DURATION_MS | (ms < DURATION_MS ? ms : DURATION_MS - 1);
+  }
+
+  // Para pasar a add() duraciones en ms sin desbordar.
+  static uint32_t fromMs(uint32_t ms) {
+    return ms < 4000000 ? ms * 1000 : 4000000000u;
+  }
+
+  static void encode(uint8_t* record, uint8_t type, uint8_t code, uint16_t duration, uint32_t time,
+                     const uint8_t* uid, uint8_t uidLength, uint32_t sequence) {
+    record[0] = type;
+    record[1] = code;
+    record[2] = duration;
+    record[3] = duration >> 8;
+    record[4] = time;
+    record[5] = time >> 8;
+    record[6] = time >> 16;
+    record[7] = time >> 24;
+    for (uint8_t i = 0; i < UID_BYTES; i++) {
+      record[8 + i] = i < uidLength ? uid[i] : 0;
+    }
+    record[12] = sequence;
+    record[13] = sequence >> 8;
+    record[14] = sequence >> 16;
+    record[15] = crc8(record, RECORD_SIZE - 1);
+  }
+
+  static bool valid(const uint8_t* record) {
+    return record[0] != 0 && crc8(record, RECORD_SIZE - 1) == record[RECORD_SIZE - 1];
+  }
+
+  static uint32_t sequence(const uint8_t* record) {
+    return record[12] | (record[13] << 8) | ((uint32_t)record[14] << 16);
+  }
+
+  // CRC-8 (polinomio 0x07), el mismo que el diario.
+  static uint8_t crc8(const uint8_t* data, uint8_t len) {
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < len; i++) {
+      crc ^= data[i];
+      for (uint8_t b = 0; b < 8; b++) {
+        crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+      }
+    }
+    return crc;
+  }
+};
+
+#if KYBER_RECORDER && defined(ENABLE_SD)
+
+class KyberRecorder : public KyberRecorderFormat {
+public:
+  KyberRecorder() : count_(0), dropped_(0), oldest_(0), recovered_(false), scanned_(0),
+                    head_(0), sequence_(0), written_(0) {}
+
+  // Guarda un evento en RAM. No toca la SD.
+  void add(Event type, uint8_t code, const uint8_t* uid = nullptr, uint8_t uidLength = 0, uint32_t us = 0) {
+    if (count_ == KYBER_RECORDER_BUFFER) {
+      dropped_++;
+      return;
+    }
+    if (count_ == 0) oldest_ = millis();
+    Entry& e = buffer_[count_++];
+    e.type = type;
+    e.code = code;
+    e.duration = duration(us);
+    e.time = millis();
+    memset(e.uid, 0, sizeof(e.uid));
+    if (uid) memcpy(e.uid, uid, uidLength < UID_BYTES ? uidLength : UID_BYTES);
+  }
+
+  // Hay algo que hacer en la SD: terminar de recorrer el fichero o escribir un lote.
+  bool due(uint32_t now) const {
+    if (!recovered_) return true;
+    if (dropped_ && count_ < KYBER_RECORDER_BUFFER) return true;
+    if (count_ >= KYBER_RECORDER_BUFFER / 2) return true;
+    return count_ > 0 && now - oldest_ >= KYBER_RECORDER_FLUSH_MS;
+  }
+
+  // Un paso: un bloque del recorrido inicial o un lote de registros.
+  void step(const char* filename) {
+    if (!recovered_) {
+      recoverStep(filename);
+    } else {
+      flush(filename);
+    }
+  }
+
+  void print() const {
+    STDOUT.print("recorder: written=");
+    STDOUT.print(written_);
+    STDOUT.print(" buffered=");
+    STDOUT.print(count_);
+    STDOUT.print(" dropped=");
+    STDOUT.print(dropped_);
+    STDOUT.print(" head=");
+    STDOUT.println(head_);
+  }
+
+private:
+  struct Entry {
+    uint8_t type;
+    uint8_t code;
+    uint16_t duration;
+    uint32_t time;
+    uint8_t uid[UID_BYTES];
+  };
+
+  static constexpr uint16_t BLOCK_RECORDS = 512 / RECORD_SIZE;
+
+  // Recorre un bloque del fichero buscando el final del anillo: el primer
+  // registro roto o que no sigue la secuencia del anterior.
+  void recoverStep(const char* filename) {
+    File f = LSFS::Open(filename);
+    if (!f) {
+      recovered_ = true;
+      return;
+    }
+    uint8_t block[BLOCK_RECORDS * RECORD_SIZE];
+    f.seek((uint32_t)scanned_ * RECORD_SIZE);
+    int n = f.read(block, sizeof(block));
+    f.close();
+
+    uint16_t records = n > 0 ? n / RECORD_SIZE : 0;
+    for (uint16_t i = 0; i < records && scanned_ < KYBER_RECORDER_RECORDS; i++) {
+      const uint8_t* record = block + i * RECORD_SIZE;
+      uint32_t seq = sequence(record);
+      if (!valid(record) || (scanned_ > 0 && seq != ((sequence_ + 1) & SEQUENCE_MASK))) {
+        finishRecovery(scanned_);
+        return;
+      }
+      sequence_ = seq;
+      scanned_++;
+    }
+    if (records < BLOCK_RECORDS || scanned_ >= KYBER_RECORDER_RECORDS) {
+      finishRecovery(scanned_ % KYBER_RECORDER_RECORDS);
+    }
+  }
+
+  void finishRecovery(uint16_t head) {
+    head_ = head;
+    if (scanned_ > 0) sequence_ = (sequence_ + 1) & SEQUENCE_MASK;
+    recovered_ = true;
+    KYBER_DEBUG("-- Recorder resumes at record %u", head_);
+  }
+
+  // Escribe todo el buffer en una apertura del fichero. Si el lote da la
+  // vuelta al anillo, en dos trozos.
+  void flush(const char* filename) {
+    if (dropped_ && count_ < KYBER_RECORDER_BUFFER) {
+      uint32_t dropped = dropped_;
+      dropped_ = 0;
+      add(EVENT_DROPPED, dropped < 255 ? dropped : 255);
+    }
+    if (!count_) return;
+
+    File f = LSFS::OpenRW(filename);
+    if (!f) {
+      KYBER_ERROR("! Recorder file error");
+      count_ = 0;
+      return;
+    }
+
+    uint8_t records[KYBER_RECORDER_BUFFER * RECORD_SIZE];
+    uint8_t i = 0;
+    while (i < count_) {
+      uint16_t run = KYBER_RECORDER_RECORDS - head_;
+      if (run > count_ - i) run = count_ - i;
+      for (uint16_t j = 0; j < run; j++) {
+        const Entry& e = buffer_[i + j];
+        encode(records + j * RECORD_SIZE, e.type, e.code, e.duration, e.time, e.uid, UID_BYTES, sequence_);
+        sequence_ = (sequence_ + 1) & SEQUENCE_MASK;
+      }
+      f.seek((uint32_t)head_ * RECORD_SIZE);
+      f.write(records, run * RECORD_SIZE);
+      head_ = (head_ + run) % KYBER_RECORDER_RECORDS;
+      i += run;
+    }
+    f.close();
+    written_ += count_;
+    count_ = 0;
+  }
+
+  Entry buffer_[KYBER_RECORDER_BUFFER];
+  uint8_t count_;
+  uint32_t dropped_;
+  uint32_t oldest_;     // millis() del evento más antiguo del buffer.
+  bool recovered_;      // Ya se sabe dónde sigue el anillo.
+  uint16_t scanned_;    // Registros válidos recorridos al arrancar.
+  uint16_t head_;       // Siguiente registro a escribir.
+  uint32_t sequence_;   // Secuencia del siguiente registro.
+  uint32_t written_;
+};
+
+#else
+
+class KyberRecorder : public KyberRecorderFormat {
+public:
+  void add(Event type, uint8_t code, const uint8_t* uid = nullptr, uint8_t uidLength = 0, uint32_t us = 0) {}
+  bool due(uint32_t now) const { return false; }
+  void step(const char* filename) {}
+  void print() const {}
+};
+
+#endif
+
+#endif
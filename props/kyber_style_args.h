@@ -0,0 +1,173 @@
+#ifndef PROPS_KYBER_STYLE_ARGS_H
+#define PROPS_KYBER_STYLE_ARGS_H
+
+// =========================================
+// KYBER STYLE ARGS - Argumentos de color del cristal en binario
+// =========================================
+// KyberRgbArg<ARG, DEFAULT> se usa en los estilos igual que RgbArg<ARG, DEFAULT>.
+// Mientras el prop no fije nada devuelve el color del argumento del preset.
+// El prop fija los colores del cristal por blade y argumento en
+// kyber_style_args (varios a la vez con apply()), en binario: el estilo en
+// marcha pasa al color nuevo sin reconstruirse ni volver a interpretar el
+// texto del preset, con un fundido si el filo está encendido. Cada
+// instancia funde desde el color que mostraba, así que un cambio a mitad de
+// otro fundido no salta.
+// Solo al guardar presets.ini se pasan a texto ("builtin P B r,g,b") con
+// format(). Los estilos que usan RgbArg en vez de KyberRgbArg no leen estos
+// valores: el prop escribe el texto antes de construir los estilos de un
+// preset nuevo y, si no hay ningún KyberRgbArg construido (users() == 0),
+// reconstruye los del mismo preset como antes.
+
+#ifndef KYBER_STYLE_ARG_SLOTS
+#define KYBER_STYLE_ARG_SLOTS 6
+#endif
+
+// Un color del cristal para un argumento de un blade.
+struct KyberStyleArg {
+  uint8_t blade;     // 1 = BLADE 1
+  uint8_t arg;       // Como en RgbArg<ARG, ...>.
+  uint8_t rgb[3];    // 8 bits por canal, como en el cristal.
+};
+
+class KyberStyleArgs {
+public:
+  struct Slot {
+    KyberStyleArg value;
+    BladeBase* blade;
+    uint16_t generation;   // Distinta en cada color fijado: cada estilo arranca ahí su fundido.
+    Color16 color;
+    uint32_t start;
+    uint16_t fadeMs;
+  };
+
+  KyberStyleArgs() : count_(0), generation_(0), users_(0) {}
+
+  // Sustituye todos los valores por los de 'args'. blades[i] es el BladeBase
+  // de args[i]; los que no existen en la configuración se ignoran.
+  void apply(const KyberStyleArg* args, BladeBase* const* blades, uint8_t count, uint16_t fadeMs) {
+    count_ = 0;
+    for (uint8_t i = 0; i < count; i++) {
+      set(args[i], blades[i], fadeMs);
+    }
+  }
+
+  void set(const KyberStyleArg& value, BladeBase* blade, uint16_t fadeMs) {
+    if (!blade) return;
+    int i = indexOf(blade, value.arg);
+    if (i < 0) {
+      if (count_ == KYBER_STYLE_ARG_SLOTS) return;
+      i = count_++;
+    }
+    Slot& slot = slots_[i];
+    slot.value = value;
+    slot.blade = blade;
+    if (++generation_ == 0) generation_ = 1;
+    slot.generation = generation_;
+    slot.color = Color16(value.rgb[0] * 257, value.rgb[1] * 257, value.rgb[2] * 257);
+    slot.start = millis();
+    slot.fadeMs = fadeMs;
+  }
+
+  const Slot* find(BladeBase* blade, uint8_t arg) const {
+    int i = indexOf(blade, arg);
+    return i < 0 ? nullptr : &slots_[i];
+  }
+
+  void clear() { count_ = 0; }
+  bool empty() const { return count_ == 0; }
+  bool has(uint8_t blade) const {
+    for (uint8_t i = 0; i < count_; i++) {
+      if (slots_[i].value.blade == blade) return true;
+    }
+    return false;
+  }
+
+  // KyberRgbArg construidos ahora mismo en los estilos.
+  uint16_t users() const { return users_; }
+  void addUser() { users_++; }
+  void removeUser() { users_--; }
+
+  // Estilo "builtin" con los argumentos fijados para un blade. Los argumentos
+  // sin valor quedan con "~" (el del preset). Devuelve false si no cabe.
+  bool format(int preset, uint8_t blade, char* out, size_t size) const {
+    int n = snprintf(out, size, "builtin %d %u", preset, blade);
+    uint8_t last = 0;
+    for (uint8_t i = 0; i < count_; i++) {
+      if (slots_[i].value.blade == blade && slots_[i].value.arg > last) last = slots_[i].value.arg;
+    }
+    for (uint8_t arg = 1; arg <= last && n > 0 && (size_t)n < size; arg++) {
+      const Slot* slot = nullptr;
+      for (uint8_t i = 0; i < count_; i++) {
+        if (slots_[i].value.blade == blade && slots_[i].value.arg == arg) slot = &slots_[i];
+      }
+      if (slot) {
+        n += snprintf(out + n, size - n, " %lu,%lu,%lu",
+                      (unsigned long)slot->color.r, (unsigned long)slot->color.g, (unsigned long)slot->color.b);
+      } else {
+        n += snprintf(out + n, size - n, " ~");
+      }
+    }
+    return n > 0 && (size_t)n < size;
+  }
+
+  // Color del fundido de 'from' al del slot en el instante 'now'.
+  static Color16 at(const Slot& slot, const Color16& from, uint32_t now) {
+    uint32_t elapsed = now - slot.start;
+    if (elapsed >= slot.fadeMs) return slot.color;
+    uint32_t x = (elapsed << 15) / slot.fadeMs;   // 0..32768
+    return Color16(lerp(from.r, slot.color.r, x),
+                   lerp(from.g, slot.color.g, x),
+                   lerp(from.b, slot.color.b, x));
+  }
+
+private:
+  int indexOf(BladeBase* blade, uint8_t arg) const {
+    for (uint8_t i = 0; i < count_; i++) {
+      if (slots_[i].blade == blade && slots_[i].value.arg == arg) return i;
+    }
+    return -1;
+  }
+
+  static uint16_t lerp(uint16_t a, uint16_t b, uint32_t x) {
+    return (a * (32768 - x) + b * x) >> 15;
+  }
+
+  Slot slots_[KYBER_STYLE_ARG_SLOTS];
+  uint8_t count_;
+  uint16_t generation_;
+  uint16_t users_;
+};
+
+KyberStyleArgs kyber_style_args;
+
+template<int ARG, class DEFAULT_COLOR>
+class KyberRgbArg {
+public:
+  KyberRgbArg() : color_(base_.getColor(0)), generation_(0) { kyber_style_args.addUser(); }
+  ~KyberRgbArg() { kyber_style_args.removeUser(); }
+
+  void run(BladeBase* blade) {
+    base_.run(blade);
+    const KyberStyleArgs::Slot* slot = kyber_style_args.find(blade, ARG);
+    if (!slot) {
+      color_ = base_.getColor(0);
+      generation_ = 0;
+      return;
+    }
+    if (slot->generation != generation_) {
+      generation_ = slot->generation;
+      from_ = color_.c;
+    }
+    color_ = SimpleColor(KyberStyleArgs::at(*slot, from_, millis()));
+  }
+
+  SimpleColor getColor(int led) { return color_; }
+
+private:
+  RgbArg<ARG, DEFAULT_COLOR> base_;
+  SimpleColor color_;
+  Color16 from_;
+  uint16_t generation_;
+};
+
+#endif
@@ -0,0 +1,280 @@
+#ifndef PROPS_KYBER_TAG_H
+#define PROPS_KYBER_TAG_H
+
+// =========================================
+// KYBER TAG - Formato de los datos del cristal
+// =========================================
+// Los datos empiezan en la página 4 del NTAG2xx.
+//
+// v1 (kyber_write.py original), 24 bytes:
+//   páginas 4-6: R G B longitud nombre(8), XOR con "ArkaivosKybr"
+//   páginas 7-9: propietario (12 bytes, sin firmar, termina en 0)
+//
+// v2, 4 bytes de cabecera y L bytes de cuerpo:
+//   0xC2 (marca 0xC, versión 2)  L  CRC-16 (LE)  R G B  campos...
+// El CRC-16/CCITT (0x1021, inicial 0xFFFF) cubre la marca, L y el cuerpo,
+// así que una escritura a medias no se acepta. Tras el color van campos TLV
+// con una cabecera de un byte: tipo en los 3 bits altos y longitud en los 5
+// bajos. Un byte 0 termina la lista y los tipos desconocidos se saltan.
+// Un cristal con color y nombre de hasta 8 caracteres ocupa 16 bytes y se
+// decodifica con un solo READ.
+//
+// Una marca 0xC2 con el CRC mal puede ser un cristal v1 con R = 0x83; solo
+// se acepta como v1 si su longitud y su nombre son válidos.
+//
+// No depende de ProffieOS ni reserva memoria, así que compila también en el
+// PC. Cada función recorre como mucho MAX_BYTES bytes.
+
+#include <stdint.h>
+#include <string.h>
+
+#ifndef KYBER_TAG_BLADE_COLORS
+#define KYBER_TAG_BLADE_COLORS 4
+#endif
+
+struct KyberBladeColor {
+  uint8_t blade;
+  uint8_t color[3];
+};
+
+struct KyberTag {
+  static constexpr uint8_t NAME_LENGTH = 24;
+  static constexpr uint8_t OWNER_LENGTH = 24;
+  static constexpr uint8_t READ_BYTES = 16;   // Un READ de NTAG2xx: 4 páginas.
+  static constexpr uint8_t MAX_BYTES = 80;    // Cinco READs como mucho.
+
+  // Bits 0-1 de flags: efecto del LED del cristal (0 = el de la configuración).
+  static constexpr uint8_t FLAG_PATTERN_MASK = 0x03;
+
+  uint8_t version;
+  uint8_t color[3];
+  char name[NAME_LENGTH + 1];    // Vacío si el cristal no indica preset.
+  char owner[OWNER_LENGTH + 1];
+  uint8_t flags;
+  uint8_t bladeColorCount;
+  KyberBladeColor bladeColors[KYBER_TAG_BLADE_COLORS];
+};
+
+class KyberTagCodec {
+public:
+  // Un target de InListPassiveTarget. Si la respuesta llegó cortada, el UID
+  // del último target puede tener solo sus primeros bytes (partial).
+  struct Target {
+    uint8_t tg;
+    uint8_t uid[7];
+    uint8_t uidLength;
+    bool partial;
+  };
+
+  static constexpr uint8_t MAX_UID = 7;   // NTAG2xx: 7 bytes.
+  static constexpr uint8_t V1_BYTES = 24;
+  static constexpr uint8_t V2_MARKER = 0xC2;
+  static constexpr uint8_t V2_HEADER = 4;
+
+  enum FieldType : uint8_t {
+    FIELD_END = 0,
+    FIELD_NAME = 1,
+    FIELD_OWNER = 2,
+    FIELD_FLAGS = 3,
+    FIELD_BLADE_COLOR = 4   // blade R G B
+  };
+
+  // Indica si con los bytes leídos (al menos un READ) aún falta algo para decodificar.
+  static bool needsMore(const uint8_t* data, uint8_t length) {
+    if (data[0] == V2_MARKER && data[1] >= 3 && data[1] <= KyberTag::MAX_BYTES - V2_HEADER) {
+      if (length < V2_HEADER + data[1]) return true;
+      // Con el CRC bien pero los campos mal puede ser un v1: decode() lo
+      // intentará con sus 24 bytes.
+      KyberTag tag;
+      if (decodeV2(data, length, &tag)) return false;
+    }
+    // v1, o una marca v2 que no lo era.
+    return length < V1_BYTES;
+  }
+
+  // Devuelve la versión decodificada o 0 si los datos no son válidos.
+  static uint8_t decode(const uint8_t* data, uint8_t length, KyberTag* tag) {
+    if (length >= V2_HEADER && data[0] == V2_MARKER) {
+      if (decodeV2(data, length, tag)) return 2;
+      if (length >= V1_BYTES && decodeV1(data, tag, true)) return 1;
+      return 0;
+    }
+    if (length >= V1_BYTES && decodeV1(data, tag, false)) return 1;
+    return 0;
+  }
+
+  // Extrae el UID de los datos de un target ISO14443A de la respuesta del
+  // PN532: Tg, SENS_RES (2), SEL_RES, NFCIDLength, NFCID...
+  static bool parseTarget(const uint8_t* target, uint8_t targetLength, uint8_t* uid, uint8_t* uidLength) {
+    if (targetLength < 5) return false;
+
+    uint8_t length = target[4];
+    if (length == 0 || length > MAX_UID || targetLength < 5 + length) return false;
+
+    memcpy(uid, target + 5, length);
+    *uidLength = length;
+    return true;
+  }
+
+  // Targets ISO14443A de una respuesta de InListPassiveTarget: NbTg y, por
+  // cada uno, Tg, SENS_RES (2), SEL_RES, NFCIDLength, NFCID y el ATS si lo
+  // hay. 'truncated' indica que la respuesta no llegó entera. Devuelve
+  // cuántos targets se han reconocido.
+  static uint8_t parseTargets(const uint8_t* response, uint8_t length, bool truncated,
+                              Target* targets, uint8_t maxTargets) {
+    if (length < 1) return 0;
+    uint8_t count = 0;
+    uint8_t i = 1;
+    while (count < response[0] && count < maxTargets) {
+      if (i + 5 > length) break;
+      const uint8_t* target = response + i;
+      uint8_t uidLength = target[4];
+      if (uidLength == 0 || uidLength > MAX_UID) break;
+
+      Target& t = targets[count];
+      t.tg = target[0];
+      if (i + 5 + uidLength > length) {
+        // Solo puede faltar el final si la respuesta venía cortada.
+        uint8_t available = length - (i + 5);
+        if (!truncated || available == 0) break;
+        memcpy(t.uid, target + 5, available);
+        t.uidLength = available;
+        t.partial = true;
+        count++;
+        break;
+      }
+      memcpy(t.uid, target + 5, uidLength);
+      t.uidLength = uidLength;
+      t.partial = false;
+      count++;
+
+      i += 5 + uidLength;
+      // ATS de las tarjetas ISO14443-4 (bit 5 de SEL_RES); las NTAG no lo tienen.
+      if ((target[3] & 0x20) && i < length) i += response[i];
+    }
+    return count;
+  }
+
+  // Un target parcial coincide si sus bytes son el principio del UID.
+  static bool matchesUID(const Target& target, const uint8_t* uid, uint8_t uidLength) {
+    if (target.partial) {
+      return uidLength >= target.uidLength && memcmp(target.uid, uid, target.uidLength) == 0;
+    }
+    return sameUID(target.uid, target.uidLength, uid, uidLength);
+  }
+
+  static bool sameUID(const uint8_t* a, uint8_t aLength, const uint8_t* b, uint8_t bLength) {
+    return aLength == bLength && memcmp(a, b, aLength) == 0;
+  }
+
+  // CRC-16/CCITT-FALSE.
+  static uint16_t crc16(const uint8_t* data, uint8_t length, uint16_t crc = 0xFFFF) {
+    for (uint8_t i = 0; i < length; i++) {
+      crc ^= (uint16_t)data[i] << 8;
+      for (uint8_t b = 0; b < 8; b++) {
+        crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+      }
+    }
+    return crc;
+  }
+
+private:
+  static void clear(KyberTag* tag) {
+    memset(tag, 0, sizeof(*tag));
+  }
+
+  static bool printable(const uint8_t* text, uint8_t length) {
+    for (uint8_t i = 0; i < length; i++) {
+      if (text[i] < 32 || text[i] > 126) return false;
+    }
+    return true;
+  }
+
+  // Copia un texto del cristal; si tiene caracteres no imprimibles queda vacío.
+  static void copyText(char* dest, uint8_t maxLength, const uint8_t* text, uint8_t length) {
+    if (length > maxLength) length = maxLength;
+    if (!printable(text, length)) length = 0;
+    memcpy(dest, text, length);
+    dest[length] = '\0';
+  }
+
+  // strict: rechazar en vez de corregir una longitud o un nombre inválidos.
+  static bool decodeV1(const uint8_t* data, KyberTag* tag, bool strict) {
+    static const uint8_t firma[12] = { 0x41, 0x72, 0x6B, 0x61, 0x69, 0x76, 0x6F, 0x73,
+                                       0x4B, 0x79, 0x62, 0x72 };
+    uint8_t decoded[12];
+    for (uint8_t i = 0; i < sizeof(decoded); i++) decoded[i] = data[i] ^ firma[i];
+
+    uint8_t nameLength = decoded[3];
+    if (nameLength > 8) {
+      if (strict) return false;
+      nameLength = 8;
+    }
+    if (strict && !printable(decoded + 4, nameLength)) return false;
+
+    clear(tag);
+    tag->version = 1;
+    memcpy(tag->color, decoded, 3);
+    copyText(tag->name, KyberTag::NAME_LENGTH, decoded + 4, nameLength);
+
+    // El propietario no va firmado y termina en el primer byte 0.
+    const uint8_t* owner = data + 12;
+    uint8_t ownerLength = 0;
+    while (ownerLength < 12 && owner[ownerLength] != 0) ownerLength++;
+    copyText(tag->owner, KyberTag::OWNER_LENGTH, owner, ownerLength);
+    return true;
+  }
+
+  static bool validV2(const uint8_t* data, uint8_t length) {
+    uint8_t bodyLength = data[1];
+    if (bodyLength < 3 || bodyLength > KyberTag::MAX_BYTES - V2_HEADER) return false;
+    if (length < V2_HEADER + bodyLength) return false;
+
+    uint16_t crc = crc16(data, 2);
+    crc = crc16(data + V2_HEADER, bodyLength, crc);
+    return crc == (uint16_t)(data[2] | (data[3] << 8));
+  }
+
+  static bool decodeV2(const uint8_t* data, uint8_t length, KyberTag* tag) {
+    if (!validV2(data, length)) return false;
+
+    uint8_t bodyLength = data[1];
+    const uint8_t* body = data + V2_HEADER;
+    clear(tag);
+    tag->version = 2;
+    memcpy(tag->color, body, 3);
+
+    uint8_t i = 3;
+    while (i < bodyLength && body[i] != FIELD_END) {
+      uint8_t type = body[i] >> 5;
+      uint8_t fieldLength = body[i] & 0x1F;
+      const uint8_t* value = body + i + 1;
+      i += 1 + fieldLength;
+      if (i > bodyLength) return false;
+
+      switch (type) {
+        case FIELD_NAME:
+          copyText(tag->name, KyberTag::NAME_LENGTH, value, fieldLength);
+          break;
+        case FIELD_OWNER:
+          copyText(tag->owner, KyberTag::OWNER_LENGTH, value, fieldLength);
+          break;
+        case FIELD_FLAGS:
+          if (fieldLength >= 1) tag->flags = value[0];
+          break;
+        case FIELD_BLADE_COLOR:
+          if (fieldLength >= 4 && tag->bladeColorCount < KYBER_TAG_BLADE_COLORS) {
+            KyberBladeColor& bc = tag->bladeColors[tag->bladeColorCount++];
+            bc.blade = value[0];
+            memcpy(bc.color, value + 1, 3);
+          }
+          break;
+        default:
+          break;  // Campo de una versión posterior.
+      }
+    }
+    return true;
+  }
+};
+
+#endif
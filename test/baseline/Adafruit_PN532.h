@@ -0,0 +1,123 @@
+#ifndef TEST_BASELINE_ADAFRUIT_PN532_H
+#define TEST_BASELINE_ADAFRUIT_PN532_H
+
+// =========================================
+// Adafruit_PN532 para versiones anteriores del prop
+// =========================================
+// Las revisiones de kyber_nfc.h que se comparan en test/baseline inicializan
+// el PN532 con la librería de Adafruit. Esto es lo que usan de ella, por I2C
+// y bloqueante como la original: tras cada trama espera al byte de estado
+// con delay(10) entre lecturas, recoge el ACK y luego la respuesta. El
+// delay() avanza el reloj virtual, así que el coste del arranque bloqueante
+// aparece en las medidas.
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#define PN532_PREAMBLE (0x00)
+#define PN532_STARTCODE1 (0x00)
+#define PN532_STARTCODE2 (0xFF)
+#define PN532_POSTAMBLE (0x00)
+#define PN532_HOSTTOPN532 (0xD4)
+#define PN532_PN532TOHOST (0xD5)
+
+#define PN532_COMMAND_GETFIRMWAREVERSION (0x02)
+#define PN532_COMMAND_SAMCONFIGURATION (0x14)
+#define PN532_COMMAND_RFCONFIGURATION (0x32)
+#define PN532_COMMAND_INDATAEXCHANGE (0x40)
+#define PN532_COMMAND_INLISTPASSIVETARGET (0x4A)
+#define PN532_COMMAND_INAUTOPOLL (0x60)
+
+#define PN532_I2C_ADDRESS (0x48 >> 1)
+#define PN532_I2C_READY (0x01)
+#define PN532_MIFARE_ISO14443A (0x00)
+#define MIFARE_CMD_READ (0x30)
+
+class Adafruit_PN532 {
+public:
+  Adafruit_PN532(uint8_t irq, uint8_t reset) {}
+
+  void begin() {}
+
+  uint32_t getFirmwareVersion() {
+    uint8_t cmd[] = { PN532_COMMAND_GETFIRMWAREVERSION };
+    if (!sendCommandCheckAck(cmd, sizeof(cmd))) return 0;
+    uint8_t response[12];
+    if (!readResponse(response, sizeof(response))) return 0;
+    // 00 00 FF LEN LCS D5 03 IC Ver Rev Support
+    return (uint32_t)response[7] << 24 | (uint32_t)response[8] << 16 |
+           (uint32_t)response[9] << 8 | response[10];
+  }
+
+  bool SAMConfig() {
+    uint8_t cmd[] = { PN532_COMMAND_SAMCONFIGURATION, 0x01, 0x14, 0x01 };
+    if (!sendCommandCheckAck(cmd, sizeof(cmd))) return false;
+    uint8_t response[9];
+    return readResponse(response, sizeof(response)) && response[6] == 0x15;
+  }
+
+  bool setPassiveActivationRetries(uint8_t maxRetries) {
+    uint8_t cmd[] = { PN532_COMMAND_RFCONFIGURATION, 0x05, 0xFF, 0x01, maxRetries };
+    if (!sendCommandCheckAck(cmd, sizeof(cmd))) return false;
+    uint8_t response[9];
+    return readResponse(response, sizeof(response));
+  }
+
+private:
+  bool sendCommandCheckAck(const uint8_t* cmd, uint8_t length, uint16_t timeout = 100) {
+    writeCommand(cmd, length);
+    if (!waitReady(timeout)) return false;
+    static const uint8_t ACK[6] = { 0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00 };
+    uint8_t ack[6];
+    if (!readData(ack, sizeof(ack))) return false;
+    return memcmp(ack, ACK, sizeof(ACK)) == 0;
+  }
+
+  bool readResponse(uint8_t* response, uint8_t length) {
+    return waitReady(1000) && readData(response, length);
+  }
+
+  void writeCommand(const uint8_t* cmd, uint8_t length) {
+    uint8_t frameLength = length + 1;
+    uint8_t checksum = PN532_HOSTTOPN532;
+    Wire.beginTransmission(PN532_I2C_ADDRESS);
+    Wire.write(PN532_PREAMBLE);
+    Wire.write(PN532_STARTCODE1);
+    Wire.write(PN532_STARTCODE2);
+    Wire.write(frameLength);
+    Wire.write((uint8_t)(~frameLength + 1));
+    Wire.write(PN532_HOSTTOPN532);
+    for (uint8_t i = 0; i < length; i++) {
+      Wire.write(cmd[i]);
+      checksum += cmd[i];
+    }
+    Wire.write((uint8_t)(~checksum + 1));
+    Wire.write(PN532_POSTAMBLE);
+    Wire.endTransmission();
+  }
+
+  bool isReady() {
+    if (Wire.requestFrom((uint8_t)PN532_I2C_ADDRESS, (uint8_t)1) != 1) return false;
+    return (Wire.read() & PN532_I2C_READY) != 0;
+  }
+
+  bool waitReady(uint16_t timeout) {
+    uint16_t waited = 0;
+    while (!isReady()) {
+      if (waited >= timeout) return false;
+      delay(10);
+      waited += 10;
+    }
+    return true;
+  }
+
+  // Byte de estado y 'length' bytes de la trama.
+  bool readData(uint8_t* data, uint8_t length) {
+    if (Wire.requestFrom((uint8_t)PN532_I2C_ADDRESS, (uint8_t)(length + 1)) != length + 1) return false;
+    Wire.read();
+    for (uint8_t i = 0; i < length; i++) data[i] = Wire.read();
+    return true;
+  }
+};
+
+#endif
@@ -0,0 +1,148 @@
+// Latencia de un cambio de cristal, medida igual con el prop actual y con
+// revisiones anteriores de props/ (KYBER_BASELINE_REFS en CMake).
+//
+// Solo usa lo que tienen todas las revisiones: Loop(), SetPreset() y el
+// estilo de la cámara. Tres cristales v1, cada uno de un preset distinto,
+// con el filo apagado; presets con RgbArg, que cualquier revisión entiende.
+// Por cada cambio:
+// - first frame: del momento en que el host lee el sondeo que trae el
+//   cristal nuevo al primer frame de la cámara con su color;
+// - insert: lo mismo, desde que el cristal entra en el campo;
+// - longest Loop(): la pasada más larga entre la detección y ese frame;
+// - style builds, font scans y SD opens hasta que el cambio se ha asentado
+//   (SETTLE_MS: el efecto de la cámara y las escrituras diferidas terminados).
+
+#include "sim_config.h"
+#include "kyber_nfc.h"
+#include "pn532_emulator.h"
+#include "sim_blades.h"
+#include "tag_image.h"
+
+Preset latency_presets[] = {
+  { "Default", "tracks/default.wav", StylePtr<SimSolidStyle<RgbArg<1, Rgb<120, 120, 120>>>>(), StylePtr<SimBlack>(), "default" },
+  { "Subdued", "tracks/default.wav", StylePtr<SimSolidStyle<RgbArg<1, Rgb<120, 120, 120>>>>(), StylePtr<SimBlack>(), "subdued" },
+  { "Obiwan", "tracks/obiwan.wav", StylePtr<SimSolidStyle<RgbArg<1, Rgb<0, 0, 255>>>>(), StylePtr<SimBlack>(), "obiwan" },
+};
+
+namespace {
+
+constexpr uint32_t LOOP_GAP_US = 200;
+constexpr uint32_t FRAME_US = 4000;
+constexpr uint32_t SETTLE_MS = 8000;
+
+struct Swap {
+  uint64_t insertedAt = 0;
+  uint64_t reportedAt = 0;
+  uint64_t frameAt = 0;
+  uint64_t longestLoop = 0;
+  uint32_t styleBuilds = 0;
+  uint32_t fontScans = 0;
+  uint32_t sdOpens = 0;
+};
+
+// El primer frame del efecto de la cámara ya tiene el color del cristal en
+// algún nivel de brillo: basta con que no sea negro.
+bool lit(Color16 c) { return c.r || c.g || c.b; }
+
+class LatencyRig {
+public:
+  SimPN532 pn532;
+  SimBlade blade1{115};
+  SimBlade blade2{1};
+  KyberNFC prop;
+  BladeConfig config;
+
+  LatencyRig() {
+    config = { 0, &blade1, &blade2, latency_presets, sizeof(latency_presets) / sizeof(latency_presets[0]), nullptr };
+    current_config = &config;
+    prop.SetPreset(0, false);
+  }
+
+  // La pasada más larga se cuenta desde que el host ve el cristal 'tag'.
+  void step(const SimTag* tag = nullptr, Swap* swap = nullptr) {
+    uint64_t start = SimClock::now();
+    prop.Loop();
+    uint64_t spent = SimClock::now() - start;
+    if (swap && !swap->frameAt && pn532.reportedAt(tag)) {
+      swap->longestLoop = std::max<uint64_t>(swap->longestLoop, spent);
+    }
+    SimClock::advance(LOOP_GAP_US);
+    if (SimClock::now() >= nextFrame_) {
+      nextFrame_ = SimClock::now() + FRAME_US;
+      blade1.frame();
+      blade2.frame();
+    }
+  }
+
+  void run(uint32_t ms) {
+    uint64_t end = SimClock::now() + (uint64_t)ms * 1000;
+    while (SimClock::now() < end) step();
+  }
+
+  // Mete el cristal y espera al primer frame de la cámara encendida con él.
+  bool swapTo(const SimTag* tag, Swap* swap) {
+    uint32_t builds = prop.stylesBuilt;
+    uint32_t scans = prop.fontScans;
+    uint32_t opens = SimSD::stats().opens;
+    swap->insertedAt = SimClock::now();
+    pn532.insert(tag);
+    uint64_t end = SimClock::now() + 5000000;
+    while (SimClock::now() < end && !swap->frameAt) {
+      step(tag, swap);
+      if (pn532.reportedAt(tag) && lit(blade2.color())) swap->frameAt = SimClock::now();
+    }
+    swap->reportedAt = pn532.reportedAt(tag);
+    run(SETTLE_MS);
+    swap->styleBuilds = prop.stylesBuilt - builds;
+    swap->fontScans = prop.fontScans - scans;
+    swap->sdOpens = SimSD::stats().opens - opens;
+    return swap->frameAt != 0;
+  }
+
+private:
+  uint64_t nextFrame_ = 0;
+};
+
+}  // namespace
+
+int main() {
+  LatencyRig rig;
+  rig.run(2000);
+
+  struct { uint8_t r, g, b; const char* name; } crystals[] = {
+    { 255, 0, 0, "subdued" }, { 0, 0, 255, "obiwan" }, { 0, 255, 0, "default" },
+  };
+  SimTag tags[3] = { SimTag(21), SimTag(22), SimTag(23) };
+  uint64_t firstFrameTotal = 0, loopTotal = 0;
+  int failures = 0;
+
+  for (int i = 0; i < 3; i++) {
+    uint8_t data[KyberTagCodec::V1_BYTES];
+    tags[i].write(data, tagImageV1(data, crystals[i].r, crystals[i].g, crystals[i].b, crystals[i].name));
+
+    Swap swap;
+    if (!rig.swapTo(&tags[i], &swap)) {
+      printf("swap %d (%s): no chamber frame within 5 s\n", i + 1, crystals[i].name);
+      failures++;
+    } else {
+      uint64_t firstFrame = swap.frameAt - swap.reportedAt;
+      firstFrameTotal += firstFrame;
+      loopTotal += swap.longestLoop;
+      printf("swap %d (%s): first frame %llu ms (insert %llu ms), longest Loop() %llu ms, "
+             "style builds %u, font scans %u, SD opens %u\n",
+             i + 1, crystals[i].name, (unsigned long long)(firstFrame / 1000),
+             (unsigned long long)((swap.frameAt - swap.insertedAt) / 1000),
+             (unsigned long long)(swap.longestLoop / 1000),
+             swap.styleBuilds, swap.fontScans, swap.sdOpens);
+    }
+
+    // La cámara se vacía antes del siguiente.
+    rig.pn532.remove(&tags[i]);
+    rig.run(3000);
+  }
+
+  if (failures) return 1;
+  printf("mean: first frame %llu ms, longest Loop() %llu ms\n",
+         (unsigned long long)(firstFrameTotal / 3000), (unsigned long long)(loopTotal / 3000));
+  return 0;
+}
@@ -0,0 +1,134 @@
+// Microbenchmarks (Google Benchmark) de lo que el prop hace con cada cristal
+// nuevo: decodificar sus bytes y buscar su preset por nombre.
+//
+// La búsqueda se mide como la hace KyberPresetIndex: con el índice ordenado
+// (findSorted) si la configuración tiene hasta KYBER_PRESET_INDEX_SIZE
+// presets y recorriéndola (findLinear) si tiene más. El índice es de uint8_t,
+// así que findSorted se mide hasta 255 presets y findLinear hasta 1000. Cada
+// iteración busca un nombre exacto, un prefijo de 5 letras y un nombre que no
+// está, repartidos por toda la tabla.
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "kyber_preset_match.h"
+#include "tag_image.h"
+
+namespace {
+
+// Como Preset de ProffieOS, en lo que usa la búsqueda.
+struct BenchPreset {
+  const char* name;
+};
+
+class PresetTable {
+public:
+  explicit PresetTable(size_t count) {
+    // Nombres de fuente de dos o tres sílabas, deterministas y con prefijos repetidos.
+    static const char* const syllables[] = { "ob", "i", "wan", "ka", "ren", "sub", "du", "ed",
+                                             "va", "der", "ta", "no", "ahs", "so", "ka", "lu" };
+    uint32_t state = 0x4B594252;
+    for (size_t i = 0; i < count; i++) {
+      std::string name;
+      for (int s = 0; s < 2 + (int)(i % 2); s++) {
+        state = state * 1103515245u + 12345u;
+        name += syllables[(state >> 16) % 16];
+      }
+      name += "_" + std::to_string(i);
+      names_.push_back(name);
+    }
+    for (const std::string& name : names_) presets_.push_back({ name.c_str() });
+    if (count <= 255) {
+      order_.resize(count);
+      KyberPresetMatch::sort(presets_.data(), count, order_.data());
+    }
+  }
+
+  const BenchPreset* presets() const { return presets_.data(); }
+  const uint8_t* order() const { return order_.data(); }
+  size_t size() const { return presets_.size(); }
+  const std::string& name(size_t i) const { return names_[i]; }
+
+private:
+  std::vector<std::string> names_;
+  std::vector<BenchPreset> presets_;
+  std::vector<uint8_t> order_;
+};
+
+// Nombres a buscar: exacto, prefijo y ausente, de presets repartidos por la tabla.
+std::vector<std::string> queries(const PresetTable& table) {
+  std::vector<std::string> result;
+  for (size_t i = 0; i < 8; i++) {
+    const std::string& name = table.name(i * table.size() / 8);
+    result.push_back(name);
+    result.push_back(name.substr(0, 5));
+    result.push_back(name + "x");
+  }
+  return result;
+}
+
+void BM_PresetFindSorted(benchmark::State& state) {
+  PresetTable table(state.range(0));
+  std::vector<std::string> names = queries(table);
+  size_t q = 0;
+  for (auto _ : state) {
+    int found = KyberPresetMatch::findSorted(table.presets(), table.order(), table.size(), names[q].c_str());
+    benchmark::DoNotOptimize(found);
+    q = q + 1 == names.size() ? 0 : q + 1;
+  }
+}
+BENCHMARK(BM_PresetFindSorted)->Arg(10)->Arg(100)->Arg(255);
+
+void BM_PresetFindLinear(benchmark::State& state) {
+  PresetTable table(state.range(0));
+  std::vector<std::string> names = queries(table);
+  size_t q = 0;
+  for (auto _ : state) {
+    int found = KyberPresetMatch::findLinear(table.presets(), table.size(), names[q].c_str());
+    benchmark::DoNotOptimize(found);
+    q = q + 1 == names.size() ? 0 : q + 1;
+  }
+}
+BENCHMARK(BM_PresetFindLinear)->Arg(10)->Arg(100)->Arg(1000);
+
+// Construir el índice: una vez por BladeConfig.
+void BM_PresetSort(benchmark::State& state) {
+  PresetTable table(state.range(0));
+  std::vector<uint8_t> order(table.size());
+  for (auto _ : state) {
+    KyberPresetMatch::sort(table.presets(), table.size(), order.data());
+    benchmark::DoNotOptimize(order.data());
+  }
+}
+BENCHMARK(BM_PresetSort)->Arg(10)->Arg(100)->Arg(255);
+
+void BM_TagDecodeV1(benchmark::State& state) {
+  uint8_t data[KyberTag::MAX_BYTES];
+  uint8_t length = tagImageV1(data, 0, 0, 255, "obiwan", "Ben");
+  KyberTag tag;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(KyberTagCodec::decode(data, length, &tag));
+  }
+}
+BENCHMARK(BM_TagDecodeV1);
+
+// v2 de un solo READ (color y nombre corto) y con todos los campos.
+void BM_TagDecodeV2(benchmark::State& state) {
+  uint8_t data[KyberTag::MAX_BYTES];
+  KyberBladeColor bladeColors[] = { { 2, { 255, 0, 0 } }, { 3, { 0, 255, 0 } } };
+  uint8_t length = state.range(0) ? tagImageV2(data, 0, 255, 0, "obiwan_kenobi", "Ben Kenobi", 2, bladeColors, 2)
+                                  : tagImageV2(data, 0, 255, 0, "obiwan");
+  KyberTag tag;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(KyberTagCodec::needsMore(data, length));
+    benchmark::DoNotOptimize(KyberTagCodec::decode(data, length, &tag));
+  }
+  state.SetLabel(std::to_string(length) + " bytes");
+}
+BENCHMARK(BM_TagDecodeV2)->Arg(0)->Arg(1);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,146 @@
+// Driver de los fuzzers sin libFuzzer (GCC): se enlaza con uno de ellos y le
+// pasa, en este orden:
+// - sus semillas y todas sus truncaciones;
+// - 'runs' entradas: una semilla (o el principio de una y el final de otra,
+//   para mezclar formatos) con de 1 a 8 mutaciones, o bytes aleatorios de
+//   longitud aleatoria.
+// Las mutaciones cambian bits, ponen bytes frontera (longitudes, marcas, no
+// imprimibles), insertan, quitan, cortan o alargan. El generador es
+// determinista: la misma 'seed' repite las mismas entradas.
+//
+//   fuzz_tag_decode [runs] [seed]
+
+#include "kyber_fuzz.h"
+
+#include <signal.h>
+#include <string.h>
+
+#if defined(__has_include)
+#if __has_include(<sanitizer/common_interface_defs.h>)
+#include <sanitizer/common_interface_defs.h>
+#define FUZZ_DEATH_CALLBACK 1
+#endif
+#endif
+
+namespace {
+
+class Rng {
+public:
+  explicit Rng(uint32_t seed) : state_(seed ? seed : 1) {}
+
+  uint32_t next() {
+    state_ ^= state_ << 13;
+    state_ ^= state_ >> 17;
+    state_ ^= state_ << 5;
+    return state_;
+  }
+
+  uint32_t below(uint32_t n) { return n ? next() % n : 0; }
+
+private:
+  uint32_t state_;
+};
+
+const uint8_t kInteresting[] = {
+  0x00, 0x01, 0x02, 0x03, 0x07, 0x08, 0x09, 0x0C, 0x10, 0x18, 0x1F, 0x20, 0x21, 0x3F, 0x40,
+  0x4B, 0x4C, 0x4D, 0x50, 0x7E, 0x7F, 0x80, 0x83, 0xC2, 0xFE, 0xFF
+};
+
+void mutate(FuzzInput* input, Rng* rng) {
+  size_t size = input->size();
+  switch (rng->below(7)) {
+    case 0:
+      if (size) (*input)[rng->below(size)] ^= (uint8_t)(1 << rng->below(8));
+      break;
+    case 1:
+      if (size) (*input)[rng->below(size)] = kInteresting[rng->below(sizeof(kInteresting))];
+      break;
+    case 2:
+      if (size) (*input)[rng->below(size)] = (uint8_t)rng->next();
+      break;
+    case 3:
+      input->insert(input->begin() + rng->below(size + 1), (uint8_t)rng->next());
+      break;
+    case 4:
+      if (size) input->erase(input->begin() + rng->below(size));
+      break;
+    case 5:
+      input->resize(rng->below(size + 1));
+      break;
+    default:
+      for (uint32_t n = 1 + rng->below(16); n; n--) input->push_back((uint8_t)rng->next());
+      break;
+  }
+}
+
+// La entrada en curso, para poder repetirla si falla.
+const FuzzInput* current = nullptr;
+
+void dumpCurrent() {
+  if (!current) return;
+  fprintf(stderr, "input (%u bytes):", (unsigned)current->size());
+  for (uint8_t b : *current) fprintf(stderr, " %02X", b);
+  fprintf(stderr, "\n");
+}
+
+void onAbort(int) {
+  dumpCurrent();
+  signal(SIGABRT, SIG_DFL);
+  abort();
+}
+
+void run(const FuzzInput& input) {
+  current = &input;
+  // Copia del tamaño justo: ASan detecta cualquier lectura fuera de ella.
+  uint8_t* data = new uint8_t[input.size() ? input.size() : 1];
+  if (!input.empty()) memcpy(data, input.data(), input.size());
+  LLVMFuzzerTestOneInput(data, input.size());
+  delete[] data;
+  current = nullptr;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint32_t runs = argc > 1 ? (uint32_t)strtoul(argv[1], nullptr, 0) : 100000;
+  uint32_t seed = argc > 2 ? (uint32_t)strtoul(argv[2], nullptr, 0) : 0x4B594252;
+
+  signal(SIGABRT, onAbort);
+#ifdef FUZZ_DEATH_CALLBACK
+  __sanitizer_set_death_callback(dumpCurrent);
+#endif
+
+  std::vector<FuzzInput> seeds;
+  kyberFuzzSeeds(&seeds);
+  uint32_t executed = 0;
+  for (const FuzzInput& s : seeds) {
+    for (size_t length = 0; length <= s.size(); length++) {
+      run(FuzzInput(s.begin(), s.begin() + length));
+      executed++;
+    }
+  }
+
+  Rng rng(seed);
+  for (uint32_t i = 0; i < runs; i++) {
+    FuzzInput input;
+    if (seeds.empty() || rng.below(8) == 0) {
+      input.resize(rng.below(129));
+      for (uint8_t& b : input) b = (uint8_t)rng.next();
+    } else {
+      input = seeds[rng.below(seeds.size())];
+      if (rng.below(4) == 0) {
+        const FuzzInput& other = seeds[rng.below(seeds.size())];
+        size_t cut = rng.below(input.size() + 1);
+        size_t from = rng.below(other.size() + 1);
+        input.resize(cut);
+        input.insert(input.end(), other.begin() + from, other.end());
+      }
+      for (uint32_t n = 1 + rng.below(8); n; n--) mutate(&input, &rng);
+    }
+    run(input);
+    executed++;
+  }
+
+  printf("%u seeds, %u inputs, seed 0x%08X: OK\n", (unsigned)seeds.size(), executed, seed);
+  return 0;
+}
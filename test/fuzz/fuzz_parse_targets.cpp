@@ -0,0 +1,73 @@
+// Fuzzer de KyberTagCodec::parseTargets(): la respuesta de InListPassiveTarget.
+//
+// El primer byte de la entrada elige si la respuesta llegó cortada (bit 0) y
+// cuántos targets caben (bit 1: uno o dos, KYBER_MAX_CRYSTALS); el resto es
+// la respuesta. Comprueba que no se escribe más allá de los targets que
+// caben, que cada UID tiene entre 1 y MAX_UID bytes copiados de la respuesta
+// y que solo el último target de una respuesta cortada puede ser parcial.
+
+#include "kyber_fuzz.h"
+#include "kyber_tag.h"
+
+#include <string.h>
+#include <initializer_list>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  if (size < 1 || size > 256) return 0;
+  bool truncated = data[0] & 0x01;
+  uint8_t maxTargets = 1 + ((data[0] >> 1) & 0x01);
+  const uint8_t* response = data + 1;
+  uint8_t length = (uint8_t)(size - 1);
+
+  // Del tamaño justo, para que ASan vea cualquier escritura de más.
+  std::vector<KyberTagCodec::Target> targets(maxTargets);
+  uint8_t count = KyberTagCodec::parseTargets(response, length, truncated, targets.data(), maxTargets);
+  FUZZ_CHECK(count <= maxTargets);
+  if (length == 0) FUZZ_CHECK(count == 0);
+  else FUZZ_CHECK(count <= response[0]);
+
+  for (uint8_t i = 0; i < count; i++) {
+    const KyberTagCodec::Target& t = targets[i];
+    FUZZ_CHECK(t.uidLength >= 1 && t.uidLength <= KyberTagCodec::MAX_UID);
+    FUZZ_CHECK(!t.partial || (truncated && i == count - 1));
+    FUZZ_CHECK(KyberTagCodec::matchesUID(t, t.uid, t.uidLength));
+    // El UID sale de la respuesta: sus bytes están en ella.
+    bool found = false;
+    for (uint8_t at = 0; at + t.uidLength <= length && !found; at++) {
+      found = memcmp(response + at, t.uid, t.uidLength) == 0;
+    }
+    FUZZ_CHECK(found);
+  }
+  return 0;
+}
+
+void kyberFuzzSeeds(std::vector<FuzzInput>* seeds) {
+  // Tg, SENS_RES (2), SEL_RES, NFCIDLength, NFCID.
+  const FuzzInput ntag = { 0x01, 0x00, 0x44, 0x00, 0x07, 0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x80 };
+  const FuzzInput ntag2 = { 0x02, 0x00, 0x44, 0x00, 0x07, 0x04, 0x66, 0x77, 0x88, 0x99, 0xAA, 0x81 };
+  const FuzzInput mifare = { 0x01, 0x00, 0x04, 0x08, 0x04, 0xDE, 0xAD, 0xBE, 0xEF };
+  // ISO14443-4 (bit 5 de SEL_RES) con su ATS: el primer byte es su longitud.
+  const FuzzInput iso4 = { 0x01, 0x03, 0x44, 0x20, 0x07, 0x04, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06,
+                           0x05, 0x78, 0x80, 0x70, 0x02 };
+
+  for (uint8_t flags = 0; flags < 4; flags++) {
+    auto add = [&](uint8_t nbTg, std::initializer_list<const FuzzInput*> list) {
+      FuzzInput input = { flags, nbTg };
+      for (const FuzzInput* target : list) input.insert(input.end(), target->begin(), target->end());
+      seeds->push_back(input);
+    };
+    add(0, {});
+    add(1, { &ntag });
+    add(1, { &mifare });
+    add(1, { &iso4 });
+    add(2, { &ntag, &ntag2 });
+    add(2, { &iso4, &ntag2 });
+    // NbTg mayor que los targets que hay, y un NFCIDLength imposible.
+    add(3, { &ntag });
+    FuzzInput bad = ntag;
+    bad[4] = 8;
+    add(1, { &bad });
+    bad[4] = 0;
+    add(2, { &ntag, &bad });
+  }
+}
@@ -0,0 +1,112 @@
+// Fuzzer de KyberTagCodec::decode() y needsMore(): los bytes de un cristal
+// tal como llegan de los READ del PN532.
+//
+// Además de no salirse de los datos, comprueba lo que el prop da por hecho:
+// - Un cristal decodificado tiene nombre y propietario imprimibles y dentro
+//   de sus campos, y no más colores por filo de los que caben.
+// - Cuando needsMore() dice que basta con lo leído, decodificar lo leído da
+//   lo mismo que decodificar el cristal entero.
+// Con la marca v2 se decodifica también una copia con el CRC corregido, para
+// que las mutaciones lleguen a los campos y no se queden en el CRC.
+
+#include "kyber_fuzz.h"
+#include "tag_image.h"
+
+#include <string.h>
+
+static bool printable(const char* text) {
+  for (; *text; text++) {
+    if (*text < 32 || *text > 126) return false;
+  }
+  return true;
+}
+
+static void checkTag(const uint8_t* data, size_t size) {
+  KyberTag full;
+  memset(&full, 0, sizeof(full));
+  uint8_t version = KyberTagCodec::decode(data, (uint8_t)size, &full);
+  FUZZ_CHECK(version <= 2);
+  if (version) {
+    FUZZ_CHECK(full.version == version);
+    FUZZ_CHECK(strlen(full.name) <= KyberTag::NAME_LENGTH && printable(full.name));
+    FUZZ_CHECK(strlen(full.owner) <= KyberTag::OWNER_LENGTH && printable(full.owner));
+    FUZZ_CHECK(full.bladeColorCount <= KYBER_TAG_BLADE_COLORS);
+    if (version == 1) FUZZ_CHECK(strlen(full.name) <= 8);
+  }
+
+  // El prop lee de READ en READ hasta que needsMore() dice que basta.
+  for (size_t length = KyberTag::READ_BYTES; length <= size; length += KyberTag::READ_BYTES) {
+    if (KyberTagCodec::needsMore(data, (uint8_t)length)) continue;
+    KyberTag partial;
+    memset(&partial, 0, sizeof(partial));
+    uint8_t partialVersion = KyberTagCodec::decode(data, (uint8_t)length, &partial);
+    FUZZ_CHECK(partialVersion == version);
+    FUZZ_CHECK(memcmp(&partial, &full, sizeof(full)) == 0);
+    break;
+  }
+  if (version == 2 && size >= KyberTag::READ_BYTES) {
+    FUZZ_CHECK(!KyberTagCodec::needsMore(data, (uint8_t)size));
+  }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  // pageData del prop: como mucho MAX_BYTES.
+  if (size > KyberTag::MAX_BYTES) return 0;
+  checkTag(data, size);
+
+  if (size >= KyberTagCodec::V2_HEADER && data[0] == KyberTagCodec::V2_MARKER) {
+    // Copia del tamaño justo, para que ASan vea cualquier lectura de más.
+    std::vector<uint8_t> fixed(data, data + size);
+    uint8_t bodyLength = fixed[1];
+    if (bodyLength <= size - KyberTagCodec::V2_HEADER) {
+      uint16_t crc = KyberTagCodec::crc16(fixed.data(), 2);
+      crc = KyberTagCodec::crc16(fixed.data() + KyberTagCodec::V2_HEADER, bodyLength, crc);
+      fixed[2] = crc & 0xFF;
+      fixed[3] = crc >> 8;
+      checkTag(fixed.data(), size);
+    }
+  }
+  return 0;
+}
+
+void kyberFuzzSeeds(std::vector<FuzzInput>* seeds) {
+  uint8_t data[KyberTag::MAX_BYTES];
+  auto add = [&](uint8_t length) { seeds->push_back(FuzzInput(data, data + length)); };
+
+  // v1: el del kyber_write.py original, con y sin propietario, y R = 0x83,
+  // que firmado empieza por la marca v2.
+  add(tagImageV1(data, 255, 0, 0, "subdued"));
+  add(tagImageV1(data, 0, 0, 255, "obiwan", "Ben Kenobi"));
+  add(tagImageV1(data, 0x83, 10, 20, "classic", "Ana"));
+  add(tagImageV1(data, 1, 2, 3, ""));
+
+  // v2: solo color, nombre corto (un READ), todos los campos y colores por filo.
+  add(tagImageV2(data, 255, 128, 0, ""));
+  add(tagImageV2(data, 0, 255, 0, "obiwan"));
+  add(tagImageV2(data, 0, 255, 0, "obiwan", "Ben", 2));
+  KyberBladeColor bladeColors[KYBER_TAG_BLADE_COLORS + 1] = {
+    { 2, { 255, 0, 0 } }, { 3, { 0, 255, 0 } }, { 1, { 0, 0, 255 } }, { 4, { 9, 9, 9 } }, { 5, { 1, 1, 1 } }
+  };
+  add(tagImageV2(data, 10, 20, 30, "a_preset_name_of_24_char", "an_owner_name_of_24_char", 3,
+                 bladeColors, 2));
+  add(tagImageV2(data, 10, 20, 30, "classic", "", 0, bladeColors, KYBER_TAG_BLADE_COLORS + 1));
+
+  // Mal formados: longitudes de cuerpo imposibles, un campo más largo que el
+  // cuerpo, texto no imprimible y la cabecera v2 sobre un cristal v1.
+  uint8_t length = tagImageV2(data, 1, 2, 3, "obiwan");
+  const uint8_t bodyLengths[] = { 0, 2, 77, 255 };
+  for (uint8_t bodyLength : bodyLengths) {
+    data[1] = bodyLength;
+    add(length);
+  }
+  length = tagImageV2(data, 1, 2, 3, "obiwan");
+  data[KyberTagCodec::V2_HEADER + 3] = (uint8_t)(KyberTagCodec::FIELD_NAME << 5 | 31);
+  add(length);
+  length = tagImageV2(data, 1, 2, 3, "obi\x01wan", "B\x7F" "en");
+  add(length);
+  length = tagImageV1(data, 1, 2, 3, "obiwan");
+  data[0] = KyberTagCodec::V2_MARKER;
+  add(length);
+  data[1] = 20;
+  add(length);
+}
@@ -0,0 +1,35 @@
+#ifndef TEST_FUZZ_KYBER_FUZZ_H
+#define TEST_FUZZ_KYBER_FUZZ_H
+
+// =========================================
+// Fuzzers de los decodificadores del prop
+// =========================================
+// Cada fuzzer define LLVMFuzzerTestOneInput(), así que con Clang se enlaza
+// con libFuzzer. Con otro compilador se enlaza con fuzz_driver.cpp, que le
+// pasa sus semillas (kyberFuzzSeeds()), todas sus truncaciones y entradas
+// derivadas de ellas o aleatorias, siempre las mismas para una misma semilla
+// del generador.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+// Una propiedad que no se cumple es un fallo, igual que un acceso fuera de
+// rango: abort() para que libFuzzer o el driver guarden la entrada.
+#define FUZZ_CHECK(cond)                                                     \
+  do {                                                                       \
+    if (!(cond)) {                                                           \
+      fprintf(stderr, "FUZZ_CHECK failed %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      abort();                                                               \
+    }                                                                        \
+  } while (0)
+
+typedef std::vector<uint8_t> FuzzInput;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+// Entradas válidas (y algunas mal formadas a propósito) de las que parte el driver.
+void kyberFuzzSeeds(std::vector<FuzzInput>* seeds);
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef TEST_SHIM_ARDUINO_H
+#define TEST_SHIM_ARDUINO_H
+
+// =========================================
+// Shim de Arduino para compilar el prop en el PC
+// =========================================
+// millis() y micros() leen un reloj virtual que solo avanza cuando algo lo
+// hace avanzar: el bus I2C simulado (Wire.h), la SD simulada (common/lsfs.h),
+// el coste estimado de reconstruir estilos o escanear una fuente
+// (props/prop_base.h), delay() y el propio bucle de la prueba. Así el tiempo
+// que mide el prop en cada Loop() es el del trabajo que hace con el hardware,
+// y cada ejecución da exactamente los mismos números.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+class SimClock {
+public:
+  static uint64_t now() { return now_; }
+  static void advance(uint64_t us) { now_ += us; }
+  static void reset() { now_ = 0; }
+
+private:
+  static inline uint64_t now_ = 0;
+};
+
+inline uint32_t millis() { return (uint32_t)(SimClock::now() / 1000); }
+inline uint32_t micros() { return (uint32_t)SimClock::now(); }
+inline void delay(uint32_t ms) { SimClock::advance((uint64_t)ms * 1000); }
+inline void delayMicroseconds(uint32_t us) { SimClock::advance(us); }
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define HEX 16
+#define DEC 10
+
+// Pines: el único que se lee es la IRQ del PN532, que conecta la prueba.
+class SimPins {
+public:
+  typedef int (*Reader)(uint8_t pin);
+  static void setReader(Reader reader) { reader_ = reader; }
+  static int read(uint8_t pin) { return reader_ ? reader_(pin) : HIGH; }
+  static void setMode(uint8_t pin, uint8_t mode) { modes_[pin] = mode; }
+  static uint8_t mode(uint8_t pin) { return modes_[pin]; }
+
+private:
+  static inline Reader reader_ = nullptr;
+  static inline uint8_t modes_[256] = {};
+};
+
+inline void pinMode(uint8_t pin, uint8_t mode) { SimPins::setMode(pin, mode); }
+inline int digitalRead(uint8_t pin) { return SimPins::read(pin); }
+
+// Pseudoaleatorio determinista (xorshift32), para que las pruebas se repitan igual.
+inline uint32_t simRandom() {
+  static uint32_t state = 0x4B594252;
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+inline long random(long max) { return max > 0 ? (long)(simRandom() % (uint32_t)max) : 0; }
+
+// El String de Arduino, lo justo para los mensajes del prop original.
+class String {
+public:
+  String() {}
+  String(const char* s) : s_(s ? s : "") {}
+  String(const std::string& s) : s_(s) {}
+  String(int v) : s_(std::to_string(v)) {}
+  String(unsigned v) : s_(std::to_string(v)) {}
+  String(long v) : s_(std::to_string(v)) {}
+  String(unsigned long v) : s_(std::to_string(v)) {}
+
+  const char* c_str() const { return s_.c_str(); }
+
+  friend String operator+(const String& a, const String& b) { return String(a.s_ + b.s_); }
+  friend String operator+(const String& a, const char* b) { return String(a.s_ + b); }
+  friend String operator+(const String& a, int b) { return a + String(b); }
+  friend String operator+(const String& a, unsigned b) { return a + String(b); }
+  friend String operator+(const String& a, long b) { return a + String(b); }
+  friend String operator+(const String& a, unsigned long b) { return a + String(b); }
+  friend String operator+(const String& a, uint8_t b) { return a + String((unsigned)b); }
+
+private:
+  std::string s_;
+};
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef TEST_SHIM_WIRE_H
+#define TEST_SHIM_WIRE_H
+
+// =========================================
+// Shim de Wire: bus I2C simulado
+// =========================================
+// Cada transferencia se entrega al dispositivo conectado en su dirección
+// (el PN532 simulado, sim/pn532_emulator.h) y avanza el reloj virtual lo que
+// tardaría en el bus a SIM_I2C_HZ: 9 bits por byte, la dirección incluida.
+// Como en la placa, el buffer es de 32 bytes.
+
+#include "Arduino.h"
+
+#ifndef SIM_I2C_HZ
+#define SIM_I2C_HZ 400000
+#endif
+
+class SimI2CDevice {
+public:
+  virtual ~SimI2CDevice() {}
+  // Escritura del maestro. false = NACK.
+  virtual bool i2cWrite(const uint8_t* data, uint8_t length) = 0;
+  // Lectura del maestro de 'length' bytes. false = NACK.
+  virtual bool i2cRead(uint8_t* data, uint8_t length) = 0;
+};
+
+class TwoWire {
+public:
+  static constexpr uint8_t BUFFER_LENGTH = 32;
+
+  void begin() {}
+  void setClock(uint32_t hz) {}
+
+  void attach(uint8_t address, SimI2CDevice* device) { devices_[address & 0x7F] = device; }
+
+  void beginTransmission(uint8_t address) {
+    address_ = address & 0x7F;
+    txLength_ = 0;
+  }
+
+  size_t write(uint8_t value) { return write(&value, 1); }
+
+  size_t write(const uint8_t* data, size_t length) {
+    size_t n = 0;
+    while (n < length && txLength_ < BUFFER_LENGTH) tx_[txLength_++] = data[n++];
+    return n;
+  }
+
+  // 0 = correcto, 2 = NACK de la dirección (como en Arduino).
+  uint8_t endTransmission(bool stop = true) {
+    busTime(txLength_);
+    transactions_++;
+    SimI2CDevice* device = devices_[address_];
+    if (!device || !device->i2cWrite(tx_, txLength_)) return 2;
+    return 0;
+  }
+
+  uint8_t requestFrom(uint8_t address, uint8_t length) {
+    if (length > BUFFER_LENGTH) length = BUFFER_LENGTH;
+    rxLength_ = 0;
+    rxPos_ = 0;
+    busTime(length);
+    transactions_++;
+    SimI2CDevice* device = devices_[address & 0x7F];
+    if (!device || !device->i2cRead(rx_, length)) return 0;
+    rxLength_ = length;
+    return length;
+  }
+
+  int available() const { return rxLength_ - rxPos_; }
+  int read() { return rxPos_ < rxLength_ ? rx_[rxPos_++] : -1; }
+
+  uint32_t transactions() const { return transactions_; }
+  uint64_t busMicros() const { return busMicros_; }
+
+private:
+  void busTime(uint8_t bytes) {
+    uint64_t us = ((uint64_t)bytes + 1) * 9 * 1000000 / SIM_I2C_HZ;
+    busMicros_ += us;
+    SimClock::advance(us);
+  }
+
+  SimI2CDevice* devices_[128] = {};
+  uint8_t address_ = 0;
+  uint8_t tx_[BUFFER_LENGTH];
+  uint8_t txLength_ = 0;
+  uint8_t rx_[BUFFER_LENGTH];
+  uint8_t rxLength_ = 0;
+  uint8_t rxPos_ = 0;
+  uint32_t transactions_ = 0;
+  uint64_t busMicros_ = 0;
+};
+
+TwoWire Wire;
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef TEST_SHIM_COMMON_I2CBUS_H
+#define TEST_SHIM_COMMON_I2CBUS_H
+
+// Shim de common/i2cbus.h: el bus está arrancado salvo que la prueba diga lo contrario.
+class I2CBus {
+public:
+  bool inited() { return inited_; }
+  void setInited(bool inited) { inited_ = inited; }
+
+private:
+  bool inited_ = true;
+};
+
+I2CBus i2cbus;
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef TEST_SHIM_COMMON_I2CDEVICE_H
+#define TEST_SHIM_COMMON_I2CDEVICE_H
+
+// Shim de common/i2cdevice.h: el cerrojo del bus de ProffieOS. La prueba lo
+// ocupa para simular una lectura del IMU en curso.
+class SimI2CLock {
+public:
+  static bool lock() {
+    if (locked_ || busy_) {
+      refused_++;
+      return false;
+    }
+    locked_ = true;
+    return true;
+  }
+  static void unlock() { locked_ = false; }
+
+  // Otro dispositivo (el IMU) tiene el bus.
+  static void setBusy(bool busy) { busy_ = busy; }
+  static bool held() { return locked_; }
+  static uint32_t refused() { return refused_; }
+
+private:
+  static inline bool locked_ = false;
+  static inline bool busy_ = false;
+  static inline uint32_t refused_ = 0;
+};
+
+inline bool I2CLock() { return SimI2CLock::lock(); }
+inline void I2CUnlock() { SimI2CLock::unlock(); }
+
+#endif
@@ -0,0 +1,185 @@
+#ifndef TEST_SHIM_COMMON_LSFS_H
+#define TEST_SHIM_COMMON_LSFS_H
+
+// =========================================
+// Shim de common/lsfs.h: SD en memoria
+// =========================================
+// Los ficheros viven en RAM y cada operación avanza el reloj virtual con un
+// coste aproximado de SdFat en una Proffieboard (SimSD::timing). Cuenta las
+// aperturas para escribir, que es lo que vigila el presupuesto de escrituras.
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../Arduino.h"
+
+// Costes de SdFat en microsegundos.
+struct SimSDTiming {
+  uint32_t open = 800;          // Buscar la entrada del directorio.
+  uint32_t readBlock = 250;     // Por bloque de 512 bytes leído.
+  uint32_t writeBlock = 1500;   // Por bloque de 512 bytes escrito.
+  uint32_t closeDirty = 2500;   // Actualizar FAT y directorio al cerrar tras escribir.
+  uint32_t remove = 2000;
+};
+
+struct SimSDStats {
+  uint32_t opens = 0;
+  uint32_t writeOpens = 0;      // Aperturas para escribir: una escritura en la SD.
+  uint32_t bytesRead = 0;
+  uint32_t bytesWritten = 0;
+  uint32_t removes = 0;
+  uint64_t busyMicros = 0;      // Tiempo total de SD.
+  std::map<std::string, uint32_t> writesByFile;
+};
+
+class SimSD {
+public:
+  typedef SimSDTiming Timing;
+  typedef SimSDStats Stats;
+  typedef std::shared_ptr<std::vector<uint8_t>> Data;
+
+  static Timing& timing() { return timing_; }
+  static Stats& stats() { return stats_; }
+  static std::map<std::string, Data>& files() { return files_; }
+
+  static void reset() {
+    files_.clear();
+    stats_ = Stats();
+  }
+
+  static bool exists(const char* path) { return files_.count(normalize(path)) != 0; }
+
+  // Contenido de un fichero (vacío si no existe).
+  static std::vector<uint8_t> contents(const char* path) {
+    auto it = files_.find(normalize(path));
+    return it == files_.end() ? std::vector<uint8_t>() : *it->second;
+  }
+
+  static void put(const char* path, const std::string& text) {
+    files_[normalize(path)] = std::make_shared<std::vector<uint8_t>>(text.begin(), text.end());
+  }
+
+  static void spend(uint32_t us) {
+    stats_.busyMicros += us;
+    SimClock::advance(us);
+  }
+
+  static uint32_t blocks(size_t bytes) { return (bytes + 511) / 512; }
+
+  static std::string normalize(const char* path) {
+    while (*path == '/') path++;
+    return path;
+  }
+
+private:
+  static inline Timing timing_;
+  static inline Stats stats_;
+  static inline std::map<std::string, Data> files_;
+};
+
+class File {
+public:
+  File() {}
+  File(SimSD::Data data, bool writable, size_t position)
+    : data_(data), writable_(writable), position_(position) {}
+
+  explicit operator bool() const { return data_ != nullptr; }
+
+  int read(void* buffer, size_t length) {
+    if (!data_) return -1;
+    size_t n = position_ < data_->size() ? std::min(length, data_->size() - position_) : 0;
+    memcpy(buffer, data_->data() + position_, n);
+    position_ += n;
+    SimSD::stats().bytesRead += n;
+    SimSD::spend(SimSD::blocks(n ? n : 1) * SimSD::timing().readBlock);
+    return (int)n;
+  }
+
+  size_t write(const void* buffer, size_t length) {
+    if (!data_ || !writable_) return 0;
+    if (data_->size() < position_ + length) data_->resize(position_ + length);
+    memcpy(data_->data() + position_, buffer, length);
+    position_ += length;
+    dirty_ = true;
+    SimSD::stats().bytesWritten += length;
+    SimSD::spend(SimSD::blocks(length) * SimSD::timing().writeBlock);
+    return length;
+  }
+
+  bool seek(uint32_t position) {
+    if (!data_ || position > data_->size()) return false;
+    position_ = position;
+    return true;
+  }
+
+  uint32_t position() const { return position_; }
+  uint32_t size() const { return data_ ? data_->size() : 0; }
+  int available() const { return data_ ? (int)(data_->size() - position_) : 0; }
+
+  void close() {
+    if (dirty_) SimSD::spend(SimSD::timing().closeDirty);
+    dirty_ = false;
+    data_ = nullptr;
+  }
+
+private:
+  SimSD::Data data_;
+  bool writable_ = false;
+  size_t position_ = 0;
+  bool dirty_ = false;
+};
+
+class LSFS {
+public:
+  static bool Exists(const char* path) {
+    SimSD::spend(SimSD::timing().open);
+    return SimSD::exists(path);
+  }
+
+  static File Open(const char* path) {
+    SimSD::spend(SimSD::timing().open);
+    auto it = SimSD::files().find(SimSD::normalize(path));
+    if (it == SimSD::files().end()) return File();
+    SimSD::stats().opens++;
+    return File(it->second, false, 0);
+  }
+
+  // Crea o vacía el fichero.
+  static File OpenForWrite(const char* path) {
+    SimSD::Data& data = openWritable(path);
+    data->clear();
+    return File(data, true, 0);
+  }
+
+  static File OpenForAppend(const char* path) {
+    SimSD::Data& data = openWritable(path);
+    return File(data, true, data->size());
+  }
+
+  // Lectura y escritura sin vaciarlo.
+  static File OpenRW(const char* path) {
+    SimSD::Data& data = openWritable(path);
+    return File(data, true, 0);
+  }
+
+  static bool Remove(const char* path) {
+    SimSD::spend(SimSD::timing().remove);
+    SimSD::stats().removes++;
+    return SimSD::files().erase(SimSD::normalize(path)) != 0;
+  }
+
+private:
+  static SimSD::Data& openWritable(const char* path) {
+    SimSD::spend(SimSD::timing().open);
+    SimSD::stats().opens++;
+    SimSD::stats().writeOpens++;
+    SimSD::stats().writesByFile[SimSD::normalize(path)]++;
+    SimSD::Data& data = SimSD::files()[SimSD::normalize(path)];
+    if (!data) data = std::make_shared<std::vector<uint8_t>>();
+    return data;
+  }
+};
+
+#endif
@@ -0,0 +1,449 @@
+#ifndef TEST_SHIM_PROPS_PROP_BASE_H
+#define TEST_SHIM_PROPS_PROP_BASE_H
+
+// =========================================
+// Shim de ProffieOS: PropBase, SaberBase, blades y estilos
+// =========================================
+// Lo justo de ProffieOS para compilar props/kyber_nfc.h en el PC, con el
+// mismo comportamiento en lo que el prop usa: SetPreset() libera los
+// estilos, carga el preset, los vuelve a construir y escanea la fuente.
+// Construir un estilo y escanear la fuente avanzan el reloj virtual
+// (SimCost) para que la latencia de un cambio de preset se parezca a la de la
+// placa. Los estilos "builtin P B args" de presets.ini toman sus argumentos
+// con RgbArg, como en ProffieOS.
+// NUM_BLADES y las opciones de la configuración vienen de sim/sim_config.h.
+
+#include <math.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../Arduino.h"
+#include "../common/lsfs.h"
+
+#ifndef NUM_BLADES
+#error "NUM_BLADES must be defined (sim_config.h)"
+#endif
+
+#if NUM_BLADES == 2
+#define ONCEPERBLADE(F) F(1) F(2)
+#else
+#error "The shim only models the two-blade configuration (blade and crystal chamber)"
+#endif
+
+// Consola: se guarda todo lo escrito para que la prueba pueda buscar mensajes.
+// Con KYBER_SIM_VERBOSE en el entorno también sale por stdout.
+class SimConsole {
+public:
+  size_t write(const uint8_t* data, size_t length) {
+    text_.append((const char*)data, length);
+    if (verbose()) fwrite(data, 1, length, stdout);
+    return length;
+  }
+
+  void print(const char* s) { write((const uint8_t*)s, strlen(s)); }
+  void print(const String& s) { print(s.c_str()); }
+  void print(char c) { write((const uint8_t*)&c, 1); }
+  void print(int v, int base = DEC) { printNumber((long)v, base); }
+  void print(unsigned v, int base = DEC) { printNumber((unsigned long)v, base); }
+  void print(long v, int base = DEC) { printNumber(v, base); }
+  void print(unsigned long v, int base = DEC) { printNumber(v, base); }
+  void print(unsigned long long v, int base = DEC) { printNumber((unsigned long)v, base); }
+
+  template<class T> void println(const T& v) { print(v); print("\n"); }
+  template<class T> void println(const T& v, int base) { print(v, base); print("\n"); }
+  void println() { print("\n"); }
+
+  const std::string& text() const { return text_; }
+  void clear() { text_.clear(); }
+  bool contains(const char* s) const { return text_.find(s) != std::string::npos; }
+
+private:
+  template<class T> void printNumber(T v, int base) {
+    char buffer[32];
+    if (base == HEX) {
+      snprintf(buffer, sizeof(buffer), "%lX", (unsigned long)v);
+    } else if (v < 0) {
+      snprintf(buffer, sizeof(buffer), "%ld", (long)v);
+    } else {
+      snprintf(buffer, sizeof(buffer), "%lu", (unsigned long)v);
+    }
+    print(buffer);
+  }
+
+  static bool verbose() {
+    static bool verbose = getenv("KYBER_SIM_VERBOSE") != nullptr;
+    return verbose;
+  }
+
+  std::string text_;
+};
+
+SimConsole STDOUT;
+
+// La tabla de senos de ProffieOS (una vuelta en 1024 pasos, ±32767). Solo la
+// usa el estilo del cristal de las versiones anteriores del prop.
+struct SimSinTable {
+  SimSinTable() {
+    for (int i = 0; i < 1024; i++) values[i] = (int16_t)lround(sin(i * 2 * M_PI / 1024) * 32767);
+  }
+  int16_t operator[](int i) const { return values[i]; }
+  int16_t values[1024];
+};
+inline const SimSinTable sin_table;
+
+// Costes estimados en la placa, en microsegundos.
+struct SimCost {
+  static inline uint32_t styleBuild = 400;   // Construir el estilo de un blade.
+  static inline uint32_t fontScan = 30000;   // chdir(): recorrer los directorios de la fuente.
+};
+
+// Cadenas en memoria dinámica, como LSPtr<char> de ProffieOS.
+template<class T>
+class LSPtr {
+public:
+  LSPtr() {}
+  explicit LSPtr(T* p) : p_(p) {}
+  LSPtr(LSPtr&& other) : p_(other.p_) { other.p_ = nullptr; }
+  LSPtr& operator=(LSPtr&& other) {
+    if (this != &other) {
+      free(p_);
+      p_ = other.p_;
+      other.p_ = nullptr;
+    }
+    return *this;
+  }
+  ~LSPtr() { free(p_); }
+
+  T* get() const { return p_; }
+  operator const T*() const { return p_; }
+
+private:
+  T* p_ = nullptr;
+};
+
+inline char* mkstr(const char* s) { return strdup(s ? s : ""); }
+
+// =========================================
+// Colores y estilos
+// =========================================
+struct Color16 {
+  Color16() : r(0), g(0), b(0) {}
+  Color16(uint16_t r_, uint16_t g_, uint16_t b_) : r(r_), g(g_), b(b_) {}
+  bool operator==(const Color16& o) const { return r == o.r && g == o.g && b == o.b; }
+  bool operator!=(const Color16& o) const { return !(*this == o); }
+  uint16_t r, g, b;
+};
+
+struct SimpleColor {
+  SimpleColor() {}
+  SimpleColor(const Color16& color) : c(color) {}
+  Color16 c;
+};
+
+struct Vec3 {
+  float x = 0, y = 0, z = 0;
+};
+
+enum HandledFeature {
+  HANDLED_FEATURE_NONE = 0,
+  HANDLED_FEATURE_CHANGE = 1,
+  HANDLED_FEATURE_STAB = 2,
+};
+
+class BladeBase;
+
+class BladeStyle {
+public:
+  virtual ~BladeStyle() {}
+  virtual void activate() {}
+  virtual void deactivate() {}
+  virtual void run(BladeBase* blade) = 0;
+  virtual bool NoOnOff() { return false; }
+  virtual bool IsHandled(HandledFeature feature) = 0;
+};
+
+class BladeBase {
+public:
+  virtual ~BladeBase() {}
+  virtual int num_leds() const = 0;
+  virtual void set(int led, Color16 c) = 0;
+
+  virtual void SetStyle(BladeStyle* style) {
+    style_ = style;
+    if (style_) style_->activate();
+  }
+
+  virtual BladeStyle* UnSetStyle() {
+    BladeStyle* style = style_;
+    if (style) style->deactivate();
+    style_ = nullptr;
+    return style;
+  }
+
+  BladeStyle* current_style() const { return style_; }
+
+protected:
+  BladeStyle* style_ = nullptr;
+};
+
+// Argumentos del estilo que se está construyendo ("builtin P B arg1 arg2...").
+class SimStyleArgs {
+public:
+  static void set(const char* args) { args_ = args ? args : ""; }
+
+  // Argumento 'arg' (desde 1) como "r,g,b" en 16 bits. false si falta o es "~".
+  static bool color(int arg, Color16* out) {
+    std::vector<std::string> tokens;
+    size_t i = 0;
+    while (i < args_.size()) {
+      while (i < args_.size() && args_[i] == ' ') i++;
+      size_t start = i;
+      while (i < args_.size() && args_[i] != ' ') i++;
+      if (i > start) tokens.push_back(args_.substr(start, i - start));
+    }
+    // builtin, preset y blade.
+    size_t index = 2 + arg;
+    if (tokens.size() <= index || tokens[index] == "~") return false;
+    unsigned r, g, b;
+    if (sscanf(tokens[index].c_str(), "%u,%u,%u", &r, &g, &b) != 3) return false;
+    *out = Color16(r, g, b);
+    return true;
+  }
+
+private:
+  static inline std::string args_;
+};
+
+template<int R, int G, int B>
+class Rgb {
+public:
+  void run(BladeBase* blade) {}
+  SimpleColor getColor(int led) { return SimpleColor(Color16(R * 257, G * 257, B * 257)); }
+};
+
+// Como RgbArg de ProffieOS: el argumento ARG del estilo o DEFAULT_COLOR.
+template<int ARG, class DEFAULT_COLOR>
+class RgbArg {
+public:
+  RgbArg() {
+    Color16 color;
+    if (SimStyleArgs::color(ARG, &color)) {
+      color_ = SimpleColor(color);
+    } else {
+      color_ = default_.getColor(0);
+    }
+  }
+  void run(BladeBase* blade) {}
+  SimpleColor getColor(int led) { return color_; }
+
+private:
+  DEFAULT_COLOR default_;
+  SimpleColor color_;
+};
+
+// Como StyleAllocator de ProffieOS.
+class StyleFactory {
+public:
+  virtual ~StyleFactory() {}
+  virtual BladeStyle* make() = 0;
+};
+typedef StyleFactory* StyleAllocator;
+
+// =========================================
+// Configuración y preset actual
+// =========================================
+struct Preset {
+  const char* font;
+  const char* track;
+  StyleAllocator style_allocator;
+  StyleAllocator style_allocator2;
+  const char* name;
+};
+
+struct BladeConfig {
+  int ohm;
+  BladeBase* blade1;
+  BladeBase* blade2;
+  Preset* presets;
+  size_t num_presets;
+  const char* save_dir;
+};
+
+BladeConfig* current_config = nullptr;
+
+class CurrentPreset {
+public:
+  int preset_num = -1;
+  LSPtr<char> font;
+  LSPtr<char> track;
+  LSPtr<char> name;
+  LSPtr<char> current_style1;
+  LSPtr<char> current_style2;
+
+  void SetPreset(int preset) {
+    preset_num = preset;
+    if (!current_config || preset < 0 || preset >= (int)current_config->num_presets) return;
+    const Preset& p = current_config->presets[preset];
+    font = LSPtr<char>(mkstr(p.font));
+    track = LSPtr<char>(mkstr(p.track));
+    name = LSPtr<char>(mkstr(p.name));
+    char style[32];
+    snprintf(style, sizeof(style), "builtin %d 1", preset);
+    current_style1 = LSPtr<char>(mkstr(style));
+    snprintf(style, sizeof(style), "builtin %d 2", preset);
+    current_style2 = LSPtr<char>(mkstr(style));
+  }
+
+  void SetStyle(int blade, LSPtr<char> style) {
+    if (blade == 1) current_style1 = std::move(style);
+    if (blade == 2) current_style2 = std::move(style);
+  }
+
+  const char* style(int blade) const { return blade == 1 ? current_style1.get() : current_style2.get(); }
+
+  // Reescribe presets.ini con el preset actual, como CurrentPreset::Save().
+  void Save() {
+    std::string ini = "installed=sim\n";
+    for (size_t i = 0; current_config && i < current_config->num_presets; i++) {
+      const Preset& p = current_config->presets[i];
+      ini += "new_preset\nfont=";
+      ini += p.font;
+      ini += "\ntrack=";
+      ini += p.track;
+      ini += "\nstyle=";
+      if ((int)i == preset_num && current_style1.get()) {
+        ini += current_style1.get();
+      } else {
+        ini += "builtin " + std::to_string(i) + " 1";
+      }
+      ini += "\nname=";
+      ini += p.name;
+      ini += "\nvariation=0\n";
+    }
+    ini += "end\n";
+    File f = LSFS::OpenForWrite("presets.ini");
+    if (f) {
+      f.write(ini.data(), ini.size());
+      f.close();
+    }
+    saves++;
+  }
+
+  uint32_t saves = 0;
+};
+
+// =========================================
+// SaberBase y PropBase
+// =========================================
+class SaberBase {
+public:
+  static bool IsOn() { return on_; }
+  static void TurnOn() { on_ = true; }
+  static void TurnOff() { on_ = false; }
+  static void DoNewFont() { newFonts_++; }
+  static uint32_t newFonts() { return newFonts_; }
+  static void reset() {
+    on_ = false;
+    newFonts_ = 0;
+  }
+
+private:
+  static inline bool on_ = false;
+  static inline uint32_t newFonts_ = 0;
+};
+
+enum BUTTON : uint32_t {
+  BUTTON_NONE = 0,
+  BUTTON_POWER = 1,
+  BUTTON_AUX = 2,
+};
+
+enum EVENT : uint32_t {
+  EVENT_NONE = 0,
+  EVENT_PRESSED,
+  EVENT_RELEASED,
+  EVENT_CLICK_SHORT,
+  EVENT_CLICK_LONG,
+  EVENT_HELD,
+  EVENT_HELD_MEDIUM,
+  EVENT_HELD_LONG,
+};
+
+#define MODE_OFF 0u
+#define MODE_ON 0x800u
+#define EVENTID(BUTTON, EVENT, MODIFIERS) (((uint32_t)(EVENT) << 24) | ((uint32_t)(BUTTON) << 12) | (uint32_t)(MODIFIERS))
+
+class PropBase {
+public:
+  virtual ~PropBase() {}
+  virtual const char* name() { return "PropBase"; }
+  virtual void Setup() {}
+  virtual void Loop() {}
+  virtual bool Event2(enum BUTTON button, EVENT event, uint32_t modifiers) { return false; }
+  virtual bool Parse(const char* cmd, const char* arg) { return false; }
+  virtual void SB_Accel(const Vec3& accel, bool clear) {}
+
+  virtual void SetPreset(int preset_num, bool announce) {
+    if (current_config && current_config->num_presets) {
+      int n = (int)current_config->num_presets;
+      preset_num = (preset_num % n + n) % n;
+    }
+    FreeBladeStyles();
+    current_preset_.SetPreset(preset_num);
+    AllocateBladeStyles();
+    chdir(current_preset_.font);
+    if (announce) SaberBase::DoNewFont();
+  }
+
+  void On() { SaberBase::TurnOn(); }
+  void Off() { SaberBase::TurnOff(); }
+
+  // Como en ProffieOS: los estilos del preset son del heap.
+  void FreeBladeStyles() {
+    if (!current_config) return;
+#define SIM_FREE_BLADE_STYLE(N) delete current_config->blade##N->UnSetStyle();
+    ONCEPERBLADE(SIM_FREE_BLADE_STYLE)
+#undef SIM_FREE_BLADE_STYLE
+  }
+
+  void AllocateBladeStyles() {
+    if (!current_config) return;
+    int preset = current_preset_.preset_num;
+    if (preset < 0 || preset >= (int)current_config->num_presets) return;
+    const Preset& p = current_config->presets[preset];
+    allocate(current_config->blade1, p.style_allocator, current_preset_.style(1));
+    allocate(current_config->blade2, p.style_allocator2, current_preset_.style(2));
+  }
+
+  void chdir(const char* dir) {
+    SimSD::spend(SimCost::fontScan);
+    fontScans++;
+  }
+
+  // Como SaveState() de ProffieOS con SAVE_PRESET: el preset actual en curstate.ini.
+  void SaveState(int preset) {
+    char text[32];
+    int n = snprintf(text, sizeof(text), "preset=%d\n", preset);
+    File f = LSFS::OpenForWrite("curstate.ini");
+    if (f) {
+      f.write(text, n);
+      f.close();
+    }
+  }
+
+  CurrentPreset current_preset_;
+  uint32_t fontScans = 0;
+  uint32_t stylesBuilt = 0;
+
+private:
+  void allocate(BladeBase* blade, StyleAllocator allocator, const char* args) {
+    if (!blade || !allocator) return;
+    SimStyleArgs::set(args);
+    SimClock::advance(SimCost::styleBuild);
+    blade->SetStyle(allocator->make());
+    SimStyleArgs::set("");
+    stylesBuilt++;
+  }
+};
+
+#endif
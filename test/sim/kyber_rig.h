@@ -0,0 +1,241 @@
+#ifndef TEST_SIM_KYBER_RIG_H
+#define TEST_SIM_KYBER_RIG_H
+
+// =========================================
+// Banco de pruebas del prop en el PC
+// =========================================
+// KyberNFC compilado contra los shims (test/shim) con un PN532 simulado en
+// el bus, dos blades (el filo y la cámara del cristal) y el bucle principal
+// de ProffieOS reducido a lo que influye en el prop: Loop() del prop, el
+// resto de loopers (LOOP_GAP_US), un frame de los blades cada FRAME_US y una
+// muestra del IMU cada MOTION_US, que también ocupa el bus.
+// Todo el tiempo es virtual (shim/Arduino.h): los resultados son exactos y
+// se repiten en cada ejecución.
+
+#include "sim_config.h"
+#include "kyber_nfc.h"
+#include "pn532_emulator.h"
+#include "sim_blades.h"
+#include "tag_image.h"
+
+// =========================================
+// Presets
+// =========================================
+// Presets con KyberRgbArg (el color cambia sin reconstruir el estilo) y uno
+// con RgbArg, que obliga a reconstruirlo desde el texto del preset.
+Preset sim_presets[] = {
+  { "Default", "tracks/default.wav",
+    StylePtr<SimSolidStyle<KyberRgbArg<1, Rgb<120, 120, 120>>>>(), StylePtr<SimBlack>(), "default" },
+  { "Subdued", "tracks/default.wav",
+    StylePtr<SimSolidStyle<KyberRgbArg<1, Rgb<120, 120, 120>>>>(), StylePtr<SimBlack>(), "subdued" },
+  { "Obiwan", "tracks/obiwan.wav",
+    StylePtr<SimSolidStyle<KyberRgbArg<1, Rgb<0, 0, 255>>>>(), StylePtr<SimBlack>(), "obiwan" },
+  { "Classic", "tracks/classic.wav",
+    StylePtr<SimSolidStyle<RgbArg<1, Rgb<0, 255, 0>>>>(), StylePtr<SimBlack>(), "classic" },
+};
+
+// =========================================
+// Cristales
+// =========================================
+inline void writeTagV1(SimTag* tag, uint8_t r, uint8_t g, uint8_t b, const char* name, const char* owner = "") {
+  uint8_t data[KyberTagCodec::V1_BYTES];
+  tag->write(data, tagImageV1(data, r, g, b, name, owner));
+}
+
+inline void writeTagV2(SimTag* tag, uint8_t r, uint8_t g, uint8_t b, const char* name,
+                       const char* owner = "", uint8_t flags = 0) {
+  uint8_t data[KyberTag::MAX_BYTES];
+  tag->write(data, tagImageV2(data, r, g, b, name, owner, flags));
+}
+
+// =========================================
+// Banco
+// =========================================
+class KyberRig {
+public:
+  static constexpr uint32_t LOOP_GAP_US = 200;   // Resto de loopers de ProffieOS.
+  static constexpr uint32_t FRAME_US = 4000;     // 115 LEDs WS2811: ~3,5 ms por frame.
+  static constexpr uint32_t MOTION_US = 625;     // IMU a 1600 Hz.
+  static constexpr uint8_t MOTION_BYTES = 12;
+
+  // Lo que dice kyber_stats.
+  struct Report {
+    uint32_t loopMax = 0, loopOver = 0, loops = 0;
+    uint32_t heavyMax = 0;
+    uint32_t swapLast = 0, swapMax = 0, swapOver = 0, swaps = 0;
+    uint32_t sdWrites = 0;
+    uint32_t readsOk = 0, readsRetried = 0, readsAborted = 0;
+    bool loopPass = false, swapPass = false;
+  };
+
+  // Primer frame de un blade con un color distinto al de cuando se empezó a vigilar.
+  struct Watch {
+    bool active = false;
+    bool seen = false;
+    uint64_t start = 0;
+    uint64_t at = 0;
+    Color16 from;
+    Color16 to;
+    uint32_t ms() const { return (uint32_t)((at - start) / 1000); }
+  };
+
+  SimPN532 pn532;
+  SimBlade blade1{115};
+  SimBlade blade2{1};
+  KyberNFC prop;
+  BladeConfig config;
+
+  KyberRig() {
+    config = { 0, &blade1, &blade2, sim_presets, sizeof(sim_presets) / sizeof(sim_presets[0]), nullptr };
+    current_config = &config;
+#ifdef NFC_IRQ_PIN
+    pn532.connectIRQ();
+#endif
+  }
+
+  // Todos los estilos son del heap, también el del cristal con el del preset
+  // que tapa.
+  ~KyberRig() {
+    for (SimBlade* blade : { &blade1, &blade2 }) delete blade->UnSetStyle();
+    if (current_config == &config) current_config = nullptr;
+  }
+
+  // Como el Setup() de ProffieOS: presets.ini y el preset guardado.
+  void boot(int preset = 0) {
+    prop.SetPreset(preset, false);
+    nextFrame_ = SimClock::now();
+    nextMotion_ = SimClock::now();
+  }
+
+  // Una vuelta del bucle principal.
+  void step() {
+    prop.Loop();
+    SimClock::advance(LOOP_GAP_US);
+    uint64_t now = SimClock::now();
+#ifdef ENABLE_MOTION
+    if (now >= nextMotion_) {
+      nextMotion_ = now + MOTION_US;
+      // La lectura del IMU ocupa el bus antes de llegar al prop.
+      SimClock::advance(((uint64_t)MOTION_BYTES + 1) * 9 * 1000000 / SIM_I2C_HZ);
+      prop.SB_Accel(Vec3(), false);
+    }
+#endif
+    if (now >= nextFrame_) {
+      nextFrame_ = now + FRAME_US;
+      blade1.frame();
+      blade2.frame();
+      check(&watch1, blade1);
+      check(&watch2, blade2);
+    }
+  }
+
+  void run(uint32_t ms) {
+    uint64_t end = SimClock::now() + (uint64_t)ms * 1000;
+    while (SimClock::now() < end) step();
+  }
+
+  // Ejecuta hasta que se cumpla 'done' o pasen 'ms'. Devuelve si se cumplió.
+  template<class F>
+  bool runUntil(F done, uint32_t ms) {
+    uint64_t end = SimClock::now() + (uint64_t)ms * 1000;
+    while (SimClock::now() < end) {
+      step();
+      if (done()) return true;
+    }
+    return false;
+  }
+
+  // kyber_log escribe en pasadas posteriores: hay que esperar a los mensajes.
+  bool waitLog(const char* message, uint32_t ms = 100) {
+    return runUntil([&] { return STDOUT.contains(message); }, ms);
+  }
+
+  // PN532 inicializado y primer SAMConfig hecho.
+  bool waitReady(uint32_t ms = 1000) {
+    return runUntil([&] { return pn532.rfOn(); }, ms);
+  }
+
+  void watch(Watch* w, const SimBlade& blade) {
+    *w = Watch();
+    w->active = true;
+    w->start = SimClock::now();
+    w->from = blade.color();
+  }
+
+  // Cristal en la cámara y primer frame con el color de la cámara cambiado.
+  // Con la cámara quieta el sondeo se espacia hasta NFC_POLL_MAX.
+  bool insert(const SimTag* tag, uint32_t ms = NFC_POLL_MAX + 1000) {
+    watch(&watch2, blade2);
+    pn532.insert(tag);
+    return runUntil([&] { return watch2.seen; }, ms);
+  }
+
+  void remove(const SimTag* tag) { pn532.remove(tag); }
+
+  void ignite() {
+    prop.Event2(BUTTON_POWER, EVENT_CLICK_SHORT, MODE_OFF);
+    sdAtIgnition_ = SimSD::stats();
+  }
+
+  void retract() {
+    sdWhileOn_ = SimSD::stats().opens - sdAtIgnition_.opens;
+    sdBusyWhileOn_ = SimSD::stats().busyMicros - sdAtIgnition_.busyMicros;
+    prop.Event2(BUTTON_POWER, EVENT_HELD_MEDIUM, MODE_ON);
+  }
+
+  // Accesos a la SD (y tiempo de SD) durante el último encendido.
+  uint32_t sdOpensWhileOn() const { return sdWhileOn_; }
+  uint64_t sdBusyWhileOn() const { return sdBusyWhileOn_; }
+
+  uint32_t writes(const char* file) const {
+    auto it = SimSD::stats().writesByFile.find(file);
+    return it == SimSD::stats().writesByFile.end() ? 0 : it->second;
+  }
+
+  Report report() {
+    size_t start = STDOUT.text().size();
+    prop.Parse("kyber_stats", nullptr);
+    std::string text = STDOUT.text().substr(start);
+    Report r;
+    r.loopPass = scan(text, "loop: max=", "%uus over=%u/%u", &r.loopMax, &r.loopOver, &r.loops) &&
+                 r.loopOver == 0;
+    scan(text, "loop (apply/sd): max=", "%uus", &r.heavyMax);
+    r.swapPass = scan(text, "swap: last=", "%ums max=%ums over=%u/%u",
+                      &r.swapLast, &r.swapMax, &r.swapOver, &r.swaps) && r.swapOver == 0;
+    scan(text, "sd writes: ", "%u", &r.sdWrites);
+    scan(text, "reads: ok=", "%u retried=%u aborted=%u", &r.readsOk, &r.readsRetried, &r.readsAborted);
+    statsText_ = text;
+    return r;
+  }
+
+  const std::string& statsText() const { return statsText_; }
+
+  Watch watch1;
+  Watch watch2;
+
+private:
+  void check(Watch* w, const SimBlade& blade) {
+    if (!w->active || w->seen) return;
+    if (blade.color() != w->from) {
+      w->seen = true;
+      w->at = SimClock::now();
+      w->to = blade.color();
+    }
+  }
+
+  template<class... A>
+  static bool scan(const std::string& text, const char* key, const char* format, A... out) {
+    size_t at = text.find(key);
+    if (at == std::string::npos) return false;
+    return sscanf(text.c_str() + at + strlen(key), format, out...) == (int)sizeof...(A);
+  }
+
+  uint64_t nextFrame_ = 0;
+  uint64_t nextMotion_ = 0;
+  SimSD::Stats sdAtIgnition_;
+  uint32_t sdWhileOn_ = 0;
+  uint64_t sdBusyWhileOn_ = 0;
+  std::string statsText_;
+};
+
+#endif
@@ -0,0 +1,560 @@
+// =========================================
+// Escenarios del prop en el banco simulado
+// =========================================
+// Cada escenario arranca el prop con la SD vacía, mete y saca cristales del
+// PN532 simulado y comprueba los presupuestos de kyber_metrics.h: el peor
+// Loop() (KYBER_LOOP_BUDGET_US), la latencia del cambio de cristal
+// (KYBER_SWAP_BUDGET_MS) y las escrituras en la SD. Además, que con el filo
+// encendido no se toca la SD y que el PN532 no ve nada fuera del protocolo.
+// Un escenario por proceso (el prop usa globales): kyber_sim <escenario>.
+// Sin argumentos lista los escenarios.
+
+#include "kyber_rig.h"
+
+#include <functional>
+#include <map>
+
+static int failures = 0;
+
+// Duración del efecto de la cámara al meter un cristal (activateCrystalLED(6000)).
+static const uint32_t FEEDBACK_MS = 6000;
+
+#define EXPECT(cond)                                                         \
+  do {                                                                       \
+    if (!(cond)) {                                                           \
+      failures++;                                                            \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);                 \
+    }                                                                        \
+  } while (0)
+
+// Presupuestos de la configuración por defecto.
+static void expectBudgets(KyberRig& rig) {
+  KyberRig::Report r = rig.report();
+  printf("loop max=%uus over=%u/%u (apply/sd max=%uus)\n", r.loopMax, r.loopOver, r.loops, r.heavyMax);
+  printf("swap last=%ums max=%ums over=%u/%u\n", r.swapLast, r.swapMax, r.swapOver, r.swaps);
+  printf("sd writes=%u opens=%u bytes=%u sd time=%lums\n", r.sdWrites, SimSD::stats().opens,
+         SimSD::stats().bytesWritten, (unsigned long)(SimSD::stats().busyMicros / 1000));
+  printf("i2c transactions=%u bus=%lums pn532 status reads=%u aborts=%u\n", Wire.transactions(),
+         (unsigned long)(Wire.busMicros() / 1000), rig.pn532.stats().statusReads, rig.pn532.stats().aborts);
+  EXPECT(r.loopPass);
+  EXPECT(r.loopMax <= KYBER_LOOP_BUDGET_US);
+  EXPECT(r.swapPass);
+  EXPECT(r.swapMax <= KYBER_SWAP_BUDGET_MS);
+  for (const std::string& e : rig.pn532.protocolErrors()) printf("pn532: %s\n", e.c_str());
+  EXPECT(rig.pn532.protocolErrors().empty());
+  EXPECT(!SimI2CLock::held());
+}
+
+// Un lote de escrituras: cada fichero del estado como mucho una vez.
+static void expectOneFlush(KyberRig& rig, uint32_t presetChanges) {
+  EXPECT(rig.writes("kyber.jnl") + rig.writes("kyber.jn2") <= 1);
+  EXPECT(rig.writes("kyber_cache.bin") <= 1);
+  EXPECT(rig.writes("presets.ini") <= 1);
+  EXPECT(rig.writes("curstate.ini") == (presetChanges ? 1u : 0u));
+}
+
+static void printSwap(const char* what, const KyberRig::Watch& w) {
+  printf("%s: %ums to the first frame (%u,%u,%u)\n", what, w.ms(), w.to.r >> 8, w.to.g >> 8, w.to.b >> 8);
+}
+
+// =========================================
+// Escenarios
+// =========================================
+
+// Arranque sin cristal: PN532 inicializado, ventana abierta, sin escrituras.
+static void scenarioBoot() {
+  KyberRig rig;
+  rig.boot();
+  EXPECT(rig.waitReady());
+  rig.run(5000);
+  EXPECT(STDOUT.contains("Found PN532"));
+  EXPECT(STDOUT.contains("-- Activating NFC"));
+  // Sondeo con InListPassiveTarget o, con NFC_IRQ_PIN, con InAutoPoll.
+  EXPECT(rig.pn532.commands(0x4A) + rig.pn532.commands(0x60) > 0);
+  EXPECT(SimSD::stats().writesByFile.count("kyber.jnl") == 0);
+  expectBudgets(rig);
+}
+
+// Cristal nuevo: lectura, preset por nombre, LED de la cámara y un único lote en la SD.
+static void scenarioInsert() {
+  KyberRig rig;
+  rig.boot();
+  EXPECT(rig.waitReady());
+  rig.run(500);
+
+  SimTag red(1);
+  writeTagV1(&red, 255, 0, 0, "subdued", "Ana");
+  uint32_t scans = rig.prop.fontScans;
+  EXPECT(rig.insert(&red));
+  printSwap("insert", rig.watch2);
+  EXPECT(rig.prop.current_preset_.preset_num == 1);
+  // La fuente se escanea al aplicar el cristal, no al encender.
+  EXPECT(rig.prop.fontScans == scans + 1);
+  EXPECT(rig.watch2.to.r > 0 && rig.watch2.to.g == 0 && rig.watch2.to.b == 0);
+  EXPECT(rig.watch2.ms() <= NFC_POLL_MIN + KYBER_SWAP_BUDGET_MS);
+
+  // Nada se escribe hasta KYBER_FLUSH_DELAY sin cambios.
+  EXPECT(SimSD::stats().writesByFile.count("kyber.jnl") == 0);
+  rig.run(KYBER_FLUSH_DELAY + 500);
+  EXPECT(rig.writes("kyber.jnl") == 1);
+  EXPECT(rig.writes("kyber_cache.bin") == 1);
+  expectOneFlush(rig, 1);
+  KyberRig::Report r = rig.report();
+  EXPECT(r.sdWrites == 4);   // presets.ini, curstate.ini, diario y caché.
+  EXPECT(r.readsOk == 1);
+
+  // El filo toma el color del cristal.
+  rig.ignite();
+  rig.run(100);
+  EXPECT(rig.blade1.color() == Color16(255 * 257, 0, 0));
+  rig.retract();
+  EXPECT(rig.sdOpensWhileOn() == 0);
+  EXPECT(rig.prop.fontScans == scans + 1);
+  expectBudgets(rig);
+}
+
+// Cristal retirado y vuelto a meter: no se vuelve a leer ni a aplicar.
+static void scenarioRemove() {
+  KyberRig rig;
+  rig.boot();
+  EXPECT(rig.waitReady());
+  SimTag tag(2);
+  writeTagV2(&tag, 0, 0, 255, "obiwan");
+  EXPECT(rig.insert(&tag));
+  uint32_t reads = rig.pn532.commands(0x40);
+  rig.run(1000);
+
+  rig.remove(&tag);
+  EXPECT(rig.runUntil([] { return STDOUT.contains("-- Crystal Removed"); }, 1000));
+  rig.pn532.insert(&tag);
+  rig.run(2000);
+  EXPECT(rig.pn532.commands(0x40) == reads);
+  EXPECT(rig.report().swaps == 1);
+  expectBudgets(rig);
+}
+
+// Cambio a un cristal de otro preset y vuelta al primero, que sale de la caché.
+static void scenarioSwap() {
+  KyberRig rig;
+  rig.boot();
+  EXPECT(rig.waitReady());
+  SimTag a(3), b(4);
+  writeTagV1(&a, 255, 0, 0, "subdued");
+  writeTagV2(&b, 0, 255, 0, "obiwan", "Ben");
+  EXPECT(rig.insert(&a));
+  rig.run(KYBER_FLUSH_DELAY + 500);
+
+  // Con el efecto del primero ya terminado, el primer cambio de la cámara es el del segundo.
+  rig.remove(&a);
+  rig.run(FEEDBACK_MS);
+  EXPECT(rig.insert(&b));
+  printSwap("swap", rig.watch2);
+  EXPECT(rig.prop.current_preset_.preset_num == 2);
+  EXPECT(rig.waitLog("-- Attuned to: Ben"));
+
+  // Vuelta al primero: de la caché, sin leer páginas.
+  rig.remove(&b);
+  rig.run(FEEDBACK_MS);
+  uint32_t reads = rig.pn532.commands(0x40);
+  EXPECT(rig.insert(&a));
+  printSwap("cached swap", rig.watch2);
+  EXPECT(rig.pn532.commands(0x40) == reads);
+  EXPECT(rig.waitLog("-- Known crystal (cache)"));
+  EXPECT(rig.prop.current_preset_.preset_num == 1);
+  expectBudgets(rig);
+}
+
+// Varios cambios seguidos con el filo apagado: una sola escritura de cada fichero.
+static void scenarioQuickSwaps() {
+  KyberRig rig;
+  rig.boot();
+  EXPECT(rig.waitReady());
+  SimTag tags[4] = { SimTag(10), SimTag(11), SimTag(12), SimTag(13) };
+  const char* names[4] = { "subdued", "obiwan", "default", "obiwan" };
+  for (int i = 0; i < 4; i++) {
+    writeTagV2(&tags[i], 40 * i, 255 - 40 * i, 0, names[i]);
+    EXPECT(rig.insert(&tags[i]));
+    rig.run(200);
+    rig.remove(&tags[i]);
+    rig.run(200);
+  }
+  EXPECT(SimSD::stats().writesByFile.count("kyber.jnl") == 0);
+  rig.run(KYBER_FLUSH_DELAY + 500);
+  expectOneFlush(rig, 1);
+  EXPECT(rig.report().swaps == 4);
+  expectBudgets(rig);
+}
+
+// Encendido justo después de meter un cristal: el encendido no escribe nada
+// y lo pendiente se guarda cuando el filo lleva un rato apagado.
+static void scenarioIgnitePending() {
+  KyberRig rig;
+  rig.boot();
+  EXPECT(rig.waitReady());
+  SimTag tag(21);
+  writeTagV1(&tag, 255, 0, 0, "subdued");
+  EXPECT(rig.insert(&tag));
+  rig.run(500);
+
+  // El registro de eventos escribe por su cuenta con el filo apagado.
+  auto stateWrites = [&] {
+    return rig.writes("kyber.jnl") + rig.writes("kyber_cache.bin") + rig.writes("presets.ini") +
+           rig.writes("curstate.ini");
+  };
+  uint32_t writeOpens = SimSD::stats().writeOpens;
+  rig.ignite();
+  EXPECT(SimSD::stats().writeOpens == writeOpens);
+  rig.run(FEEDBACK_MS);
+  rig.retract();
+  EXPECT(rig.sdOpensWhileOn() == 0);
+
+  // Ni durante la retracción.
+  rig.run(KYBER_FLUSH_DELAY / 2);
+  EXPECT(stateWrites() == 0);
+  rig.run(KYBER_FLUSH_DELAY);
+  expectOneFlush(rig, 1);
+  EXPECT(rig.writes("kyber.jnl") == 1);
+  expectBudgets(rig);
+}
+
+// Cristal cambiado con el filo encendido: el color funde sin tocar la SD y el
+// preset se aplica tras apagarlo.
+static void scenarioLiveSwap() {
+  KyberRig rig;
+  rig.boot();
+  EXPECT(rig.waitReady());
+  SimTag a(5), b(6);
+  writeTagV1(&a, 255, 0, 0, "subdued");
+  writeTagV1(&b, 0, 0, 255, "obiwan");
+  EXPECT(rig.insert(&a));
+  rig.run(KYBER_FLUSH_DELAY + 500);
+
+  rig.ignite();
+  rig.run(500);
+  rig.remove(&a);
+  rig.run(300);
+  rig.watch(&rig.watch1, rig.blade1);
+  rig.pn532.insert(&b);
+  EXPECT(rig.runUntil([&] { return rig.blade1.color() == Color16(0, 0, 255 * 257); }, 2000));
+  EXPECT(rig.watch1.seen);
+  printSwap("live swap", rig.watch1);
+  printf("live swap: full color after %lums\n", (unsigned long)((SimClock::now() - rig.watch1.start) / 1000));
+  EXPECT(rig.prop.current_preset_.preset_num == 1);
+  // Mientras dura el efecto del cristal el filo no se apaga.
+  rig.run(FEEDBACK_MS);
+  rig.retract();
+  EXPECT(!SaberBase::IsOn());
+  EXPECT(rig.sdOpensWhileOn() == 0);
+  EXPECT(rig.sdBusyWhileOn() == 0);
+
+  rig.run(KYBER_FLUSH_DELAY + 500);
+  EXPECT(rig.prop.current_preset_.preset_num == 2);
+  expectBudgets(rig);
+}
+
+// Estilos sin KyberRgbArg: el color llega reconstruyendo el estilo desde el texto.
+static void scenarioRgbArgPreset() {
+  KyberRig rig;
+  rig.boot();
+  EXPECT(rig.waitReady());
+  SimTag tag(7);
+  writeTagV2(&tag, 255, 128, 0, "classic");
+  uint32_t builds = rig.prop.stylesBuilt;
+  EXPECT(rig.insert(&tag));
+  EXPECT(rig.prop.current_preset_.preset_num == 3);
+  EXPECT(kyber_style_args.users() == 0);
+  // Los estilos del preset nuevo se construyen una sola vez, ya con el color.
+  EXPECT(rig.prop.stylesBuilt - builds == NUM_BLADES);
+  rig.ignite();
+  rig.run(100);
+  EXPECT(rig.blade1.color() == Color16(255 * 257, 128 * 257, 0));
+  rig.retract();
+  expectBudgets(rig);
+}
+
+// Un READ fallido se retoma desde la página que falló; agotados los
+// reintentos, el cristal no se vuelve a leer hasta retirarlo.
+static void scenarioReadRetry() {
+  KyberRig rig;
+  rig.boot();
+  EXPECT(rig.waitReady());
+  SimTag tag(8);
+  writeTagV1(&tag, 0, 255, 0, "obiwan");
+  rig.pn532.failReads(1);
+  EXPECT(rig.insert(&tag));
+  KyberRig::Report r = rig.report();
+  EXPECT(r.readsRetried == 1);
+  EXPECT(r.readsOk == 1);
+  EXPECT(rig.prop.current_preset_.preset_num == 2);
+  expectBudgets(rig);
+}
+
+static void scenarioReadFail() {
+  KyberRig rig;
+  rig.boot();
+  EXPECT(rig.waitReady());
+  SimTag tag(9);
+  writeTagV1(&tag, 0, 255, 0, "obiwan");
+  rig.pn532.failReads(100);
+  EXPECT(!rig.insert(&tag, 3000));
+  EXPECT(STDOUT.contains("! Error reading crystal"));
+  uint32_t reads = rig.pn532.commands(0x40);
+  EXPECT(reads == 1 + KYBER_READ_RETRIES);
+  rig.run(3000);
+  EXPECT(rig.pn532.commands(0x40) == reads);
+  EXPECT(rig.prop.current_preset_.preset_num == 0);
+
+  // Retirado y vuelto a meter, ya sin fallos, se lee.
+  rig.pn532.failReads(0);
+  rig.remove(&tag);
+  EXPECT(rig.runUntil([] { return STDOUT.contains("-- Crystal Removed"); }, NFC_POLL_MAX * 2));
+  EXPECT(rig.insert(&tag));
+  EXPECT(rig.prop.current_preset_.preset_num == 2);
+  expectBudgets(rig);
+}
+
+// La ventana NFC se cierra con PowerDown y el siguiente apagado del filo la
+// vuelve a abrir despertando al PN532.
+static void scenarioWindowTimeout() {
+  KyberRig rig;
+  rig.boot();
+  EXPECT(rig.waitReady());
+  EXPECT(rig.runUntil([] { return STDOUT.contains("-- PN532 powered down"); }, NFC_TIMEOUT * 1000 + 1000));
+  EXPECT(rig.pn532.asleep());
+  uint32_t transactions = Wire.transactions();
+  rig.run(10000);
+  EXPECT(Wire.transactions() == transactions);
+
+  // Un cristal con la ventana cerrada no se ve.
+  SimTag tag(14);
+  writeTagV2(&tag, 255, 0, 255, "subdued");
+  rig.pn532.insert(&tag);
+  rig.run(1000);
+  EXPECT(rig.prop.current_preset_.preset_num == 0);
+
+  rig.ignite();
+  rig.run(1000);
+  rig.retract();
+  rig.watch(&rig.watch2, rig.blade2);
+  EXPECT(rig.runUntil([&] { return rig.watch2.seen; }, 1000));
+  printSwap("after wake-up", rig.watch2);
+  EXPECT(rig.pn532.stats().wakeUps == 1);
+  EXPECT(rig.prop.current_preset_.preset_num == 1);
+  expectBudgets(rig);
+}
+
+// La ventana se cierra con el filo encendido y un cristal cambiado en
+// caliente: lo pendiente no se escribe hasta apagar el filo.
+static void scenarioWindowTimeoutOn() {
+  KyberRig rig;
+  rig.boot();
+  EXPECT(rig.waitReady());
+  SimTag a(19), b(20);
+  writeTagV1(&a, 255, 0, 0, "subdued");
+  writeTagV2(&b, 0, 0, 255, "obiwan");
+  EXPECT(rig.insert(&a));
+  rig.run(KYBER_FLUSH_DELAY + 500);
+  uint32_t cacheWrites = rig.writes("kyber_cache.bin");
+
+  rig.ignite();
+  rig.run(500);
+  rig.remove(&a);
+  rig.run(300);
+  rig.pn532.insert(&b);
+  EXPECT(rig.runUntil([&] { return rig.blade1.color() == Color16(0, 0, 255 * 257); }, 2000));
+  EXPECT(rig.runUntil([] { return STDOUT.contains("-- PN532 powered down"); }, NFC_TIMEOUT * 1000 + 1000));
+  EXPECT(SaberBase::IsOn());
+  rig.retract();
+  EXPECT(rig.sdOpensWhileOn() == 0);
+
+  // Tras la retracción se aplica el preset y, sin más cambios, se guarda todo.
+  rig.run(2 * KYBER_FLUSH_DELAY + 500);
+  EXPECT(rig.writes("kyber_cache.bin") == cacheWrites + 1);
+  EXPECT(rig.prop.current_preset_.preset_num == 2);
+  expectBudgets(rig);
+}
+
+// Con el cerrojo del bus tomado por el IMU, el PN532 espera sin bloquear.
+static void scenarioBusLocked() {
+  KyberRig rig;
+  rig.boot();
+  EXPECT(rig.waitReady());
+  SimTag tag(15);
+  writeTagV2(&tag, 255, 255, 0, "subdued");
+  SimI2CLock::setBusy(true);
+  rig.pn532.insert(&tag);
+  uint32_t transactions = Wire.transactions();
+  rig.run(1000);
+  EXPECT(Wire.transactions() == transactions);
+  EXPECT(SimI2CLock::refused() > 0);
+  SimI2CLock::setBusy(false);
+  rig.watch(&rig.watch2, rig.blade2);
+  EXPECT(rig.runUntil([&] { return rig.watch2.seen; }, 1000));
+  EXPECT(rig.prop.current_preset_.preset_num == 1);
+  expectBudgets(rig);
+}
+
+// Sin PN532 en el bus: se reintenta cada 5 s sin pasarse del presupuesto.
+static void scenarioNoModule() {
+  KyberRig rig;
+  Wire.attach(SimPN532::ADDRESS, nullptr);
+  rig.boot();
+  rig.run(12000);
+  EXPECT(STDOUT.contains("-- NFC Module not found"));
+  EXPECT(STDOUT.contains("-- Ready"));
+  KyberRig::Report r = rig.report();
+  EXPECT(r.loopPass);
+}
+
+// Reinicio con un cristal guardado: el preset se restaura del diario en el
+// arranque, antes del primer encendido, sin leer el cristal.
+static void scenarioReboot() {
+  std::map<std::string, SimSD::Data> sd;
+  {
+    KyberRig rig;
+    rig.boot();
+    EXPECT(rig.waitReady());
+    SimTag tag(16);
+    writeTagV1(&tag, 0, 0, 255, "obiwan");
+    EXPECT(rig.insert(&tag));
+    rig.run(KYBER_FLUSH_DELAY + 500);
+    sd = SimSD::files();
+  }
+  SimSD::reset();
+  SimSD::files() = sd;
+  KyberRig rig;
+  rig.boot();
+  rig.run(50);
+  EXPECT(STDOUT.contains("-- Loading saved preset: 2"));
+  EXPECT(rig.prop.current_preset_.preset_num == 2);
+  EXPECT(SimSD::stats().writeOpens == 0);
+  rig.ignite();
+  rig.run(100);
+  EXPECT(rig.blade1.color() == Color16(0, 0, 255 * 257));
+  rig.retract();
+  EXPECT(rig.sdOpensWhileOn() == 0);
+}
+
+// ProffieOS libera los estilos por su cuenta con el del cristal montado: lo
+// destruye con el del preset que tapa (ASan vigila los dos) y el prop lo da
+// por apagado. Un cambio de preset del prop, en cambio, no corta el efecto.
+static void scenarioFreeStyles() {
+  KyberRig rig;
+  rig.boot();
+  EXPECT(rig.waitReady());
+  SimTag red(19), blue(20);
+  writeTagV1(&red, 255, 0, 0, "subdued");
+  writeTagV1(&blue, 0, 0, 255, "obiwan");
+  EXPECT(rig.insert(&red));
+  CrystalLEDStyle* crystal = CrystalLEDStyle::instance();
+  EXPECT(crystal && rig.blade2.current_style() == crystal);
+
+  rig.prop.SetPreset(2, false);
+  EXPECT(CrystalLEDStyle::instance() == crystal && rig.blade2.current_style() == crystal);
+
+  rig.prop.FreeBladeStyles();
+  EXPECT(CrystalLEDStyle::instance() == nullptr);
+  rig.prop.AllocateBladeStyles();
+  rig.run(FEEDBACK_MS);
+  EXPECT(rig.blade2.current_style() != nullptr);
+
+  // El siguiente cristal vuelve a montar el LED, y el prop lo desmonta al acabar el efecto.
+  rig.remove(&red);
+  rig.run(1000);
+  EXPECT(rig.insert(&blue));
+  EXPECT(rig.watch2.to.b > 0);
+  EXPECT(CrystalLEDStyle::instance() != nullptr);
+  rig.run(FEEDBACK_MS + 500);
+  EXPECT(CrystalLEDStyle::instance() == nullptr);
+}
+
+// El diario guarda índices de preset de más de un byte y sigue leyendo los
+// registros de la versión 1.
+static void scenarioJournal() {
+  const uint8_t color[3] = { 10, 20, 30 };
+  KyberJournal journal;
+  journal.record(300, color);
+  EXPECT(journal.flush("kyber.jnl", "kyber.jn2"));
+  KyberJournal::State state;
+  KyberJournal recovered;
+  EXPECT(recovered.recover("kyber.jnl", "kyber.jn2", &state));
+  EXPECT(state.preset == 300);
+  EXPECT(state.color[0] == 10 && state.color[1] == 20 && state.color[2] == 30);
+
+  // Uno de la versión 1, más nuevo, en el otro fichero.
+  std::string v1 = { 'K', 1, 9, 0, 0, 0, 7, 40, 50, 60, 0 };
+  uint8_t crc = 0;
+  for (char c : v1) {
+    crc ^= (uint8_t)c;
+    for (int b = 0; b < 8; b++) crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+  }
+  SimSD::put("kyber.jn2", v1 + (char)crc);
+  EXPECT(recovered.recover("kyber.jnl", "kyber.jn2", &state));
+  EXPECT(state.preset == 7);
+  EXPECT(state.color[0] == 40 && state.color[1] == 50 && state.color[2] == 60);
+}
+
+#if KYBER_MAX_CRYSTALS > 1
+// Dos cristales en la cámara: el segundo da el argumento 2 del filo.
+static void scenarioSecondCrystal() {
+  KyberRig rig;
+  rig.boot();
+  EXPECT(rig.waitReady());
+  SimTag a(17), b(18);
+  writeTagV1(&a, 255, 0, 0, "subdued");
+  writeTagV2(&b, 0, 255, 0, "");
+  EXPECT(rig.insert(&a));
+  rig.pn532.insert(&b);
+  EXPECT(rig.runUntil([] { return STDOUT.contains("-- Second crystal (0,255,0)"); }, 2000));
+  const KyberStyleArgs::Slot* slot = kyber_style_args.find(&rig.blade1, KYBER_SECOND_CRYSTAL_ARG);
+  EXPECT(slot && slot->color == Color16(0, 255 * 257, 0));
+  EXPECT(rig.prop.current_preset_.preset_num == 1);
+  rig.remove(&b);
+  EXPECT(rig.runUntil([] { return STDOUT.contains("-- Second Crystal Removed"); }, 2000));
+  EXPECT(!kyber_style_args.find(&rig.blade1, KYBER_SECOND_CRYSTAL_ARG));
+  expectBudgets(rig);
+}
+#endif
+
+int main(int argc, char** argv) {
+  std::map<std::string, std::function<void()>> scenarios = {
+    { "boot", scenarioBoot },
+    { "insert", scenarioInsert },
+    { "remove", scenarioRemove },
+    { "swap", scenarioSwap },
+    { "quick_swaps", scenarioQuickSwaps },
+    { "ignite_pending", scenarioIgnitePending },
+    { "live_swap", scenarioLiveSwap },
+    { "rgbarg_preset", scenarioRgbArgPreset },
+    { "read_retry", scenarioReadRetry },
+    { "read_fail", scenarioReadFail },
+    { "window_timeout", scenarioWindowTimeout },
+    { "window_timeout_on", scenarioWindowTimeoutOn },
+    { "bus_locked", scenarioBusLocked },
+    { "no_module", scenarioNoModule },
+    { "reboot", scenarioReboot },
+    { "free_styles", scenarioFreeStyles },
+    { "journal", scenarioJournal },
+#if KYBER_MAX_CRYSTALS > 1
+    { "second_crystal", scenarioSecondCrystal },
+#endif
+  };
+
+  if (argc < 2) {
+    for (const auto& s : scenarios) printf("%s\n", s.first.c_str());
+    return 0;
+  }
+  auto it = scenarios.find(argv[1]);
+  if (it == scenarios.end()) {
+    printf("unknown scenario: %s\n", argv[1]);
+    return 2;
+  }
+  it->second();
+  if (failures) {
+    printf("--- prop output ---\n%s", STDOUT.text().c_str());
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("PASS\n");
+  return 0;
+}
@@ -0,0 +1,387 @@
+#ifndef TEST_SIM_PN532_EMULATOR_H
+#define TEST_SIM_PN532_EMULATOR_H
+
+// =========================================
+// PN532 simulado en el bus I2C
+// =========================================
+// Responde como el PN532 en modo I2C (manual de usuario del PN532, 6.2.4 y
+// 7): cada lectura empieza por el byte de estado (bit 0 = lista) y el ACK y
+// la respuesta solo se entregan cuando están listos, según el reloj virtual.
+// Una trama ACK del host aborta el comando en curso. Tras el PowerDown el
+// primer acceso no recibe ACK y lo despierta; hasta que arranca el oscilador
+// tampoco responde.
+// Los cristales (SimTag) se ponen y se quitan del campo desde la prueba. Todo
+// lo que el host haga fuera del protocolo (tramas mal formadas, leer una
+// respuesta que no está lista, comandos sin configurar el SAM) se cuenta en
+// protocolErrors() con su motivo.
+
+#include <string>
+#include <vector>
+#include <Wire.h>
+
+// Un NTAG2xx: UID de 7 bytes y sus páginas de 4 bytes.
+struct SimTag {
+  static constexpr uint8_t PAGES = 45;   // NTAG213.
+
+  uint8_t uid[7] = {};
+  uint8_t pages[PAGES][4] = {};
+
+  SimTag() {}
+  explicit SimTag(uint32_t id) {
+    uid[0] = 0x04;   // Fabricante: NXP.
+    for (uint8_t i = 1; i < 7; i++) uid[i] = (uint8_t)(id >> ((i - 1) % 4 * 8)) ^ (uint8_t)(i * 0x1D);
+  }
+
+  // Datos del prop desde la página 4.
+  void write(const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length && 16 + i < PAGES * 4; i++) pages[4 + i / 4][i % 4] = data[i];
+  }
+};
+
+class SimPN532 : public SimI2CDevice {
+public:
+  static constexpr uint8_t ADDRESS = 0x24;
+
+  // Tiempos del PN532 en microsegundos.
+  struct Timing {
+    uint32_t ack = 600;              // Del fin de la trama del host al ACK.
+    uint32_t command = 1000;         // Comandos sin RF (firmware, configuración, PowerDown).
+    uint32_t listEmpty = 2500;       // InListPassiveTarget sin cristal (MxRtyPassiveActivation = 1).
+    uint32_t listTarget = 3500;      // InListPassiveTarget con un cristal, más listTarget/2 por cada otro.
+    uint32_t read = 2000;            // READ de 4 páginas.
+    uint32_t readFail = 5000;        // READ sin respuesta del cristal.
+    uint32_t autoPollPeriod = 150000;  // Unidad del periodo de InAutoPoll.
+    uint32_t wakeUp = 2000;          // Arranque del oscilador tras despertar.
+  };
+
+  struct Stats {
+    uint32_t commands[256] = {};
+    uint32_t aborts = 0;
+    uint32_t wakeUps = 0;
+    uint32_t powerDowns = 0;
+    uint32_t statusReads = 0;
+    uint32_t nacks = 0;
+  };
+
+  SimPN532() { Wire.attach(ADDRESS, this); }
+  ~SimPN532() { Wire.attach(ADDRESS, nullptr); }
+
+  Timing& timing() { return timing_; }
+  const Stats& stats() const { return stats_; }
+
+  // =========================================
+  // Cristales en el campo
+  // =========================================
+  void insert(const SimTag* tag) {
+    remove(tag);
+    field_.push_back({ tag, SimClock::now(), 0 });
+  }
+
+  void remove(const SimTag* tag) {
+    for (size_t i = 0; i < field_.size(); i++) {
+      if (field_[i].tag == tag) {
+        field_.erase(field_.begin() + i);
+        return;
+      }
+    }
+  }
+
+  void clearField() { field_.clear(); }
+
+  // Los siguientes 'count' READ fallan (acoplamiento justo de la antena).
+  void failReads(uint32_t count) { failReads_ = count; }
+
+  // =========================================
+  // Estado para la prueba
+  // =========================================
+  bool asleep() const { return sleeping_; }
+  bool rfOn() const { return !sleeping_ && samConfigured_; }
+  bool irqLow() { return ready(); }
+  uint32_t commands(uint8_t cmd) const { return stats_.commands[cmd]; }
+
+  // Cuándo leyó el host la primera respuesta de sondeo con el cristal (0: aún no).
+  uint64_t reportedAt(const SimTag* tag) const {
+    for (const InField& f : field_) {
+      if (f.tag == tag) return f.reported;
+    }
+    return 0;
+  }
+
+  const std::vector<std::string>& protocolErrors() const { return errors_; }
+
+  // El pin IRQ: en bajo cuando hay un ACK o una respuesta que recoger.
+  static int irqReader(uint8_t pin) {
+    return instance_ && instance_->ready() ? LOW : HIGH;
+  }
+  void connectIRQ() {
+    instance_ = this;
+    SimPins::setReader(&SimPN532::irqReader);
+  }
+
+  // =========================================
+  // SimI2CDevice
+  // =========================================
+  bool i2cWrite(const uint8_t* data, uint8_t length) override {
+    if (!accessible()) return false;
+
+    static const uint8_t ACK_FRAME[6] = { 0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00 };
+    if (length == 0) return true;
+    if (length == 6 && !memcmp(data, ACK_FRAME, 6)) {
+      if (state_ != IDLE) stats_.aborts++;
+      state_ = IDLE;
+      return true;
+    }
+
+    // 00 00 FF LEN LCS D4 CMD datos DCS 00
+    if (length < 9 || data[0] != 0x00 || data[1] != 0x00 || data[2] != 0xFF) {
+      return error("malformed frame");
+    }
+    uint8_t len = data[3];
+    if ((uint8_t)(len + data[4]) != 0 || length != len + 7) return error("bad frame length");
+    if (data[5] != 0xD4) return error("bad TFI");
+    uint8_t checksum = 0;
+    for (uint8_t i = 0; i <= len; i++) checksum += data[5 + i];
+    if (checksum != 0) return error("bad DCS");
+    if (data[6 + len] != 0x00) return error("missing postamble");
+    if (state_ != IDLE) error("command while another one is pending");
+
+    startCommand(data + 6, len - 1);
+    return true;
+  }
+
+  bool i2cRead(uint8_t* data, uint8_t length) override {
+    if (!accessible()) return false;
+    memset(data, 0, length);
+    bool isReady = ready();
+    data[0] = isReady ? 0x01 : 0x00;
+    if (length == 1) {
+      stats_.statusReads++;
+      return true;
+    }
+    if (!isReady) {
+      error("frame read before ready");
+      return true;
+    }
+
+    if (state_ == ACK_PENDING) {
+      static const uint8_t ACK_FRAME[6] = { 0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00 };
+      if (length < 7) error("short ACK read");
+      memcpy(data + 1, ACK_FRAME, length - 1 < 6 ? length - 1 : 6);
+      state_ = RESPONSE_PENDING;
+      return true;
+    }
+
+    // Trama de respuesta; lo que no quepa en la lectura se pierde, como en el PN532.
+    std::vector<uint8_t> frame = responseFrame();
+    for (size_t i = 0; i + 1 < length && i < frame.size(); i++) data[i + 1] = frame[i];
+    state_ = IDLE;
+    if (command_ == CMD_IN_LIST_PASSIVE_TARGET || command_ == CMD_IN_AUTO_POLL) {
+      for (InField& f : field_) {
+        for (const SimTag* tag : selected_) {
+          if (f.tag == tag && !f.reported) f.reported = SimClock::now();
+        }
+      }
+    }
+    if (command_ == CMD_POWER_DOWN) {
+      sleeping_ = true;
+      samConfigured_ = false;
+      stats_.powerDowns++;
+    }
+    return true;
+  }
+
+private:
+  static constexpr uint8_t CMD_GET_FIRMWARE_VERSION = 0x02;
+  static constexpr uint8_t CMD_SAM_CONFIGURATION = 0x14;
+  static constexpr uint8_t CMD_POWER_DOWN = 0x16;
+  static constexpr uint8_t CMD_RF_CONFIGURATION = 0x32;
+  static constexpr uint8_t CMD_IN_DATA_EXCHANGE = 0x40;
+  static constexpr uint8_t CMD_IN_LIST_PASSIVE_TARGET = 0x4A;
+  static constexpr uint8_t CMD_IN_AUTO_POLL = 0x60;
+
+  enum State {
+    IDLE,
+    ACK_PENDING,
+    RESPONSE_PENDING
+  };
+
+  struct InField {
+    const SimTag* tag;
+    uint64_t since;
+    uint64_t reported;   // Primera respuesta de sondeo con el cristal que ha leído el host.
+  };
+
+  // Dormido, el primer acceso lo despierta sin ACK; mientras arranca, tampoco hay ACK.
+  bool accessible() {
+    uint64_t now = SimClock::now();
+    if (sleeping_) {
+      sleeping_ = false;
+      wakeAt_ = now + timing_.wakeUp;
+      stats_.wakeUps++;
+      stats_.nacks++;
+      return false;
+    }
+    if (now < wakeAt_) {
+      stats_.nacks++;
+      error("access while the oscillator starts");
+      return false;
+    }
+    return true;
+  }
+
+  bool ready() {
+    if (sleeping_ || state_ == IDLE) return false;
+    uint64_t now = SimClock::now();
+    if (state_ == ACK_PENDING) return now >= ackAt_;
+    if (command_ == CMD_IN_AUTO_POLL) return autoPollReady(now);
+    return now >= responseAt_;
+  }
+
+  // InAutoPoll responde en el primer ciclo de sondeo con un cristal en el campo.
+  bool autoPollReady(uint64_t now) {
+    if (field_.empty()) return false;
+    uint64_t period = (uint64_t)timing_.autoPollPeriod * (autoPollPeriod_ ? autoPollPeriod_ : 1);
+    uint64_t since = field_[0].since > commandAt_ ? field_[0].since - commandAt_ : 0;
+    uint64_t tick = commandAt_ + (since + period - 1) / period * period;
+    if (now < tick + timing_.listTarget) return false;
+    autoPollTag_ = field_[0].tag;
+    return true;
+  }
+
+  bool error(const char* reason) {
+    errors_.push_back(reason);
+    return true;
+  }
+
+  void startCommand(const uint8_t* cmd, uint8_t length) {
+    uint64_t now = SimClock::now();
+    command_ = cmd[0];
+    stats_.commands[command_]++;
+    commandAt_ = now;
+    ackAt_ = now + timing_.ack;
+    state_ = ACK_PENDING;
+    response_.clear();
+    uint32_t delay = timing_.command;
+
+    switch (command_) {
+      case CMD_GET_FIRMWARE_VERSION:
+        response_ = { 0x32, 0x01, 0x06, 0x07 };   // PN532 v1.6.
+        break;
+
+      case CMD_SAM_CONFIGURATION:
+        samConfigured_ = true;
+        break;
+
+      case CMD_RF_CONFIGURATION:
+        break;
+
+      case CMD_POWER_DOWN:
+        response_ = { 0x00 };
+        break;
+
+      case CMD_IN_LIST_PASSIVE_TARGET: {
+        if (!samConfigured_) error("InListPassiveTarget without SAMConfiguration");
+        uint8_t maxTg = length > 1 ? cmd[1] : 1;
+        if (maxTg < 1 || maxTg > 2) error("bad MaxTg");
+        uint8_t count = 0;
+        response_.push_back(0);
+        selected_.clear();
+        for (size_t i = 0; i < field_.size() && count < maxTg; i++) {
+          const SimTag* tag = field_[i].tag;
+          selected_.push_back(tag);
+          count++;
+          appendTarget(count, tag);
+        }
+        response_[0] = count;
+        delay = count ? timing_.listTarget + (count - 1) * timing_.listTarget / 2 : timing_.listEmpty;
+        break;
+      }
+
+      case CMD_IN_DATA_EXCHANGE: {
+        uint8_t tg = length > 1 ? cmd[1] : 0;
+        const SimTag* tag = tg >= 1 && tg <= selected_.size() ? selected_[tg - 1] : nullptr;
+        if (length < 4 || cmd[2] != 0x30) error("unsupported InDataExchange");
+        if (!tag) error("InDataExchange without a selected target");
+        bool inField = false;
+        for (const InField& f : field_) inField |= f.tag == tag;
+        if (!tag || !inField || failReads_ > 0) {
+          if (failReads_ > 0) failReads_--;
+          response_ = { 0x01 };   // Timeout: el cristal no responde.
+          delay = timing_.readFail;
+          break;
+        }
+        response_.push_back(0x00);
+        uint8_t page = cmd[3];
+        for (uint8_t i = 0; i < 16; i++) {
+          uint8_t p = page + i / 4;
+          response_.push_back(p < SimTag::PAGES ? tag->pages[p][i % 4] : 0);
+        }
+        delay = timing_.read;
+        break;
+      }
+
+      case CMD_IN_AUTO_POLL: {
+        if (!samConfigured_) error("InAutoPoll without SAMConfiguration");
+        autoPollPeriod_ = length > 2 ? cmd[2] : 1;
+        // La respuesta se construye con el cristal que haya cuando esté lista.
+        break;
+      }
+
+      default:
+        error("unsupported command");
+        break;
+    }
+    responseAt_ = ackAt_ + delay;
+  }
+
+  void appendTarget(uint8_t tg, const SimTag* tag) {
+    const uint8_t header[] = { tg, 0x00, 0x44, 0x00, 0x07 };   // SENS_RES de NTAG2xx, SEL_RES 0.
+    response_.insert(response_.end(), header, header + sizeof(header));
+    response_.insert(response_.end(), tag->uid, tag->uid + 7);
+  }
+
+  std::vector<uint8_t> responseFrame() {
+    if (command_ == CMD_IN_AUTO_POLL) {
+      // NbTg, tipo (Mifare/NTAG a 106 kbps), longitud y los datos del target.
+      response_ = { 1, 0x10, 12 };
+      selected_.assign(1, autoPollTag_);
+      appendTarget(1, autoPollTag_);
+    }
+    std::vector<uint8_t> frame = { 0x00, 0x00, 0xFF };
+    uint8_t len = (uint8_t)(response_.size() + 2);
+    frame.push_back(len);
+    frame.push_back((uint8_t)(~len + 1));
+    frame.push_back(0xD5);
+    frame.push_back(command_ + 1);
+    uint8_t checksum = 0xD5 + command_ + 1;
+    for (uint8_t b : response_) {
+      frame.push_back(b);
+      checksum += b;
+    }
+    frame.push_back((uint8_t)(~checksum + 1));
+    frame.push_back(0x00);
+    return frame;
+  }
+
+  static inline SimPN532* instance_ = nullptr;
+
+  Timing timing_;
+  Stats stats_;
+  std::vector<InField> field_;
+  std::vector<const SimTag*> selected_;
+  const SimTag* autoPollTag_ = nullptr;   // El cristal que ha encontrado InAutoPoll.
+  std::vector<uint8_t> response_;
+  std::vector<std::string> errors_;
+  State state_ = IDLE;
+  uint8_t command_ = 0;
+  uint8_t autoPollPeriod_ = 1;
+  uint64_t commandAt_ = 0;
+  uint64_t ackAt_ = 0;
+  uint64_t responseAt_ = 0;
+  uint64_t wakeAt_ = 0;
+  uint32_t failReads_ = 0;
+  bool sleeping_ = false;
+  bool samConfigured_ = false;
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef TEST_SIM_SIM_BLADES_H
+#define TEST_SIM_SIM_BLADES_H
+
+// Blades y estilos de prueba. No dependen del prop, así que sirven también
+// para compilar versiones anteriores de kyber_nfc.h (test/baseline).
+
+#include <vector>
+
+#include "prop_base.h"
+
+// =========================================
+// Estilos de prueba
+// =========================================
+// Un color en todo el blade; con el filo apagado, negro salvo ALWAYS_ON.
+template<class COLOR, bool ALWAYS_ON = false>
+class SimSolidStyle : public BladeStyle {
+public:
+  void run(BladeBase* blade) override {
+    color_.run(blade);
+    Color16 c = ALWAYS_ON || SaberBase::IsOn() ? color_.getColor(0).c : Color16();
+    for (int i = 0; i < blade->num_leds(); i++) blade->set(i, c);
+  }
+  bool IsHandled(HandledFeature feature) override { return true; }
+
+private:
+  COLOR color_;
+};
+
+template<class STYLE>
+class SimStyleFactory : public StyleFactory {
+public:
+  BladeStyle* make() override { return new STYLE(); }
+};
+
+template<class STYLE>
+StyleAllocator StylePtr() {
+  static SimStyleFactory<STYLE> factory;
+  return &factory;
+}
+
+typedef SimSolidStyle<Rgb<0, 0, 0>, true> SimBlack;
+
+// =========================================
+// Blade con los LEDs en memoria
+// =========================================
+class SimBlade : public BladeBase {
+public:
+  explicit SimBlade(int leds) : leds_(leds) {}
+
+  int num_leds() const override { return (int)leds_.size(); }
+  void set(int led, Color16 c) override { leds_[led] = c; }
+
+  void frame() {
+    if (style_) style_->run(this);
+    frames_++;
+  }
+
+  Color16 color(int led = 0) const { return leds_[led]; }
+  uint32_t frames() const { return frames_; }
+
+private:
+  std::vector<Color16> leds_;
+  uint32_t frames_ = 0;
+};
+
+#endif
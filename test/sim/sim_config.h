@@ -0,0 +1,15 @@
+#ifndef TEST_SIM_SIM_CONFIG_H
+#define TEST_SIM_SIM_CONFIG_H
+
+// Configuración de la placa simulada: la de config/kyber_config.h en lo que
+// mira el prop (audio, IMU y SD), para compilarlo como en la placa. CMake
+// compila además una variante con NFC_IRQ_PIN y otra con KYBER_MAX_CRYSTALS 2.
+#define NUM_BLADES 2
+#define NUM_BUTTONS 1
+#define ENABLE_AUDIO
+#define ENABLE_MOTION
+#define ENABLE_SD
+#define SAVE_PRESET
+#define NFC_TIMEOUT 60
+
+#endif
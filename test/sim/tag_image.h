@@ -0,0 +1,62 @@
+#ifndef TEST_SIM_TAG_IMAGE_H
+#define TEST_SIM_TAG_IMAGE_H
+
+// =========================================
+// Contenido de un cristal, como lo escribe kyber_write.py
+// =========================================
+// Los bytes desde la página 4 en los dos formatos de props/kyber_tag.h. Los
+// usan el banco (para grabar los SimTag) y las semillas del fuzzer.
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+
+#include "kyber_tag.h"
+
+// v1 (el de kyber_write.py original): color y nombre firmados, propietario. Ocupa V1_BYTES.
+inline uint8_t tagImageV1(uint8_t* data, uint8_t r, uint8_t g, uint8_t b, const char* name,
+                          const char* owner = "") {
+  static const uint8_t firma[12] = { 0x41, 0x72, 0x6B, 0x61, 0x69, 0x76, 0x6F, 0x73, 0x4B, 0x79, 0x62, 0x72 };
+  uint8_t length = (uint8_t)std::min<size_t>(strlen(name), 8);
+  memset(data, 0, KyberTagCodec::V1_BYTES);
+  data[0] = r;
+  data[1] = g;
+  data[2] = b;
+  data[3] = length;
+  memcpy(data + 4, name, length);
+  for (uint8_t i = 0; i < 12; i++) data[i] ^= firma[i];
+  memcpy(data + 12, owner, std::min<size_t>(strlen(owner), 12));
+  return KyberTagCodec::V1_BYTES;
+}
+
+// v2: cabecera con CRC-16 y campos TLV. 'data' tiene sitio para KyberTag::MAX_BYTES.
+inline uint8_t tagImageV2(uint8_t* data, uint8_t r, uint8_t g, uint8_t b, const char* name,
+                          const char* owner = "", uint8_t flags = 0,
+                          const KyberBladeColor* bladeColors = nullptr, uint8_t bladeColorCount = 0) {
+  memset(data, 0, KyberTag::MAX_BYTES);
+  uint8_t* body = data + KyberTagCodec::V2_HEADER;
+  uint8_t n = 0;
+  body[n++] = r;
+  body[n++] = g;
+  body[n++] = b;
+  auto field = [&](uint8_t type, const void* value, uint8_t length) {
+    body[n++] = (uint8_t)(type << 5 | length);
+    memcpy(body + n, value, length);
+    n += length;
+  };
+  if (name[0]) field(KyberTagCodec::FIELD_NAME, name, (uint8_t)strlen(name));
+  if (owner[0]) field(KyberTagCodec::FIELD_OWNER, owner, (uint8_t)strlen(owner));
+  if (flags) field(KyberTagCodec::FIELD_FLAGS, &flags, 1);
+  for (uint8_t i = 0; i < bladeColorCount; i++) {
+    field(KyberTagCodec::FIELD_BLADE_COLOR, &bladeColors[i], sizeof(KyberBladeColor));
+  }
+  data[0] = KyberTagCodec::V2_MARKER;
+  data[1] = n;
+  uint16_t crc = KyberTagCodec::crc16(data, 2);
+  crc = KyberTagCodec::crc16(body, n, crc);
+  data[2] = crc & 0xFF;
+  data[3] = crc >> 8;
+  return KyberTagCodec::V2_HEADER + n;
+}
+
+#endif